@@ -0,0 +1,116 @@
+/*****************************************************************************
+ * @file      bench_escape.c
+ * @author    Peter Hillerström <prohstream@gmail.com>
+ * @copyright 2025, Peter Hillerström
+ * @license   MIT
+ * @date      16 oct 2026
+ ****************************************************************************/
+/**
+ * @brief     Escape codec throughput benchmark
+ * @details   Decodes a file of quoted, escape-heavy values with ini_open()
+ *            and encodes the raw values with ini_set(), which quotes and
+ *            escapes them. Long plain runs and dense escapes are
+ *            measured separately, both in MB/s of value text.
+ ****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include "../ini.h"
+
+#define BENCH_FILE     "./build/bench_escape.ini"
+#define BENCH_SECTIONS (2000)
+#define BENCH_KEYS     (40)
+#define BENCH_VALUE    (200)
+#define BENCH_ROUNDS   (5)
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void
+make_value(char* p_value,
+           int dense,
+           int seed)
+{
+    /* Raw value with an escaped character every 4 or every 50 bytes */
+    static const char special[] = "\"\\\n\t#\x01";
+    for (int i = 0; i < BENCH_VALUE; ++i) {
+        p_value[i] = (i + 1) % (dense ? 4 : 50) == 0 ? special[(i + seed) % 6] : (char)('a' + (i + seed) % 26);
+    }
+    p_value[BENCH_VALUE] = '\0';
+}
+
+static void
+run(const char* p_name,
+    int dense)
+{
+    char value[BENCH_VALUE + 1];
+    double best_decode = 1e9, best_encode = 1e9;
+    ini_txn_t* p_txn = NULL;
+
+    /* Same escapes as ini_set() writes, quoted values are decoded on open */
+    FILE* file = fopen(BENCH_FILE, "w");
+    assert(file != NULL);
+    for (int s = 0; s < BENCH_SECTIONS; ++s) {
+        fprintf(file, "[section_%d]\n", s);
+        for (int k = 0; k < BENCH_KEYS; ++k) {
+            make_value(value, dense, s + k);
+            fprintf(file, "key_%d = \"", k);
+            for (const char* p = value; *p; ++p) {
+                switch (*p) {
+                    case '"': case '\\': fprintf(file, "\\%c", *p); break;
+                    case '\n': fputs("\\n", file); break;
+                    case '\t': fputs("\\t", file); break;
+                    case '\x01': fputs("\\x01", file); break;
+                    default: fputc(*p, file); break;
+                }
+            }
+            fputs("\"\n", file);
+        }
+    }
+    fclose(file);
+
+    /* Decode, ini_open() unescapes every value */
+    for (int i = 0; i < BENCH_ROUNDS; ++i) {
+        ini_doc_t* doc = NULL;
+        double start = now();
+        int result = ini_open(BENCH_FILE, &doc);
+        double elapsed = now() - start;
+        assert(result == 0);
+        const char* p_value;
+        size_t len;
+        make_value(value, dense, 7 + 3);
+        assert(ini_get_view(doc, "section_7", "key_3", &p_value, &len) == 0 && len == BENCH_VALUE && memcmp(p_value, value, len) == 0);
+        ini_close(doc);
+        if (elapsed < best_decode) best_decode = elapsed;
+    }
+
+    /* Encode, a set of the same key replaces the previous one */
+    for (int i = 0; i < BENCH_ROUNDS; ++i) {
+        assert(ini_begin(BENCH_FILE, &p_txn) == 0);
+        double start = now();
+        for (int n = 0; n < BENCH_SECTIONS * BENCH_KEYS; ++n) {
+            value[0] ^= 1; /* Defeat hoisting */
+            assert(ini_set(p_txn, "section", "key", value, NULL) == 0);
+        }
+        double elapsed = now() - start;
+        ini_abort(p_txn);
+        if (elapsed < best_encode) best_encode = elapsed;
+    }
+
+    double mb = (double)BENCH_SECTIONS * BENCH_KEYS * BENCH_VALUE / 1e6;
+    printf("%-24s decode %8.1f MB/s  encode %8.1f MB/s\n", p_name, mb / best_decode, mb / best_encode);
+    remove(BENCH_FILE);
+}
+
+int main(void) {
+    ini_parse_threads(1);
+    run("escape sparse", 0);
+    run("escape dense", 1);
+    return 0;
+}
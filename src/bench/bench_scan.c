@@ -0,0 +1,102 @@
+/*****************************************************************************
+ * @file      bench_scan.c
+ * @author    Peter Hillerström <prohstream@gmail.com>
+ * @copyright 2025, Peter Hillerström
+ * @license   MIT
+ * @date      16 oct 2026
+ ****************************************************************************/
+/**
+ * @brief     Parser throughput benchmark
+ * @details   Generates a large INI file and reports ini_open() MB/s.
+ *            Built twice, against the SIMD and the scalar (INI_NO_SIMD)
+ *            tokenizer, to compare them. The SIMD build also parses with
+ *            1 to 8 threads to show how chunked parsing scales.
+ ****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include "../ini.h"
+
+#define BENCH_FILE     "./build/bench_scan.ini"
+#define BENCH_SECTIONS (20000)
+#define BENCH_KEYS     (40)
+#define BENCH_ROUNDS   (5)
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static long
+generate(const char* filename,
+         int long_lines)
+{
+    FILE* file = fopen(filename, "w");
+    assert(file != NULL);
+    for (int s = 0; s < BENCH_SECTIONS; ++s) {
+        fprintf(file, "[section_%d]\n", s);
+        fprintf(file, "; Generated section comment\n");
+        for (int k = 0; k < (long_lines ? BENCH_KEYS / 4 : BENCH_KEYS); ++k) {
+            if (long_lines) { /* Scanning dominates */
+                fprintf(file, "key_%d = %0*d ; %0*d\n", k, 160, s, 60, k);
+                continue;
+            }
+            switch (k % 4) { /* Entry handling dominates */
+                case 0: fprintf(file, "key_%d = %d\n", k, s * k); break;
+                case 1: fprintf(file, "Key_%d: some longer value with spaces %d ; inline comment\n", k, k); break;
+                case 2: fprintf(file, "  key_%d   =   \"quoted value %d\"\n", k, s); break;
+                default: fprintf(file, "key_%d=/usr/local/share/settings/path/to/resource/%d/%d.dat\n", k, s, k); break;
+            }
+        }
+        fprintf(file, "\n");
+    }
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+static void
+run(const char* p_name,
+    int long_lines)
+{
+    long size = generate(BENCH_FILE, long_lines);
+    double best = 1e9;
+
+    for (int i = 0; i < BENCH_ROUNDS; ++i) {
+        ini_doc_t* doc = NULL;
+        double start = now();
+        int result = ini_open(BENCH_FILE, &doc);
+        double elapsed = now() - start;
+        assert(result == 0);
+        ini_close(doc);
+        if (elapsed < best) best = elapsed;
+    }
+
+    char buffer[256];
+    assert(ini_read_key(BENCH_FILE, "section_19999", "key_2", buffer, sizeof(buffer)) > 0);
+    printf("%-24s %8.1f MB  %8.2f ms  %8.1f MB/s\n", p_name, size / 1e6, best * 1e3, size / 1e6 / best);
+    remove(BENCH_FILE);
+}
+
+int main(void) {
+#ifdef INI_NO_SIMD
+    ini_parse_threads(1);
+    run("ini_open short scalar", 0);
+    run("ini_open long scalar", 1);
+#else
+    ini_parse_threads(1);
+    run("ini_open short", 0);
+    run("ini_open long", 1);
+    for (unsigned threads = 2; threads <= 8; threads *= 2) {
+        char name[32];
+        ini_parse_threads(threads);
+        snprintf(name, sizeof(name), "ini_open short %ut", threads);
+        run(name, 0);
+    }
+#endif
+    return 0;
+}
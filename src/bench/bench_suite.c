@@ -0,0 +1,267 @@
+/*****************************************************************************
+ * @file      bench_suite.c
+ * @author    Peter Hillerström <prohstream@gmail.com>
+ * @copyright 2025, Peter Hillerström
+ * @license   MIT
+ * @date      16 oct 2026
+ ****************************************************************************/
+/**
+ * @brief     Reproducible read/write benchmark suite
+ * @details   Generates deterministic INI files from 1 KB to 100 MB in three
+ *            shapes and times the file, handle, batch and write APIs on
+ *            them. Prints one JSON object per result line with ns/op, MB/s
+ *            and library allocations per op, for diffing between releases.
+ *            INI_BENCH_MAX caps the file size in bytes, INI_BENCH_TIME sets
+ *            the seconds spent per measurement.
+ ****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include "../ini.h"
+
+#define BENCH_FILE     "./build/bench_suite.ini"
+#define BENCH_TIME     (0.25)   /* Default seconds per measurement */
+#define BENCH_NAME_LEN (32)
+
+/* Library allocations, counted through the linker's --wrap */
+static atomic_ulong allocs;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* p_mem, size_t size);
+
+void* __wrap_malloc(size_t size) { atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed); return __real_malloc(size); }
+void* __wrap_calloc(size_t count, size_t size) { atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed); return __real_calloc(count, size); }
+void* __wrap_realloc(void* p_mem, size_t size) { atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed); return __real_realloc(p_mem, size); }
+
+/* File shape */
+struct profile {
+    const char* p_name;
+    int sections;       /* 0 for a new section every keys_per_section keys */
+    int keys_per_section;
+    int value_len;
+    int quoted;         /* Quoted values with escapes */
+};
+
+static const struct profile profiles[] = {
+    { "many_sections", 0, 8, 8, 0 },
+    { "few_sections", 4, 0, 200, 0 },
+    { "quoted", 0, 32, 40, 1 },
+};
+
+static const long sizes[] = { 1L << 10, 64L << 10, 1L << 20, 16L << 20, 100L << 20 };
+
+/* Keys looked up in each file */
+struct targets {
+    char first[2][BENCH_NAME_LEN];  /* Section, key */
+    char middle[2][BENCH_NAME_LEN];
+    char last[2][BENCH_NAME_LEN];
+};
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static long
+generate(const char* filename,
+         const struct profile* p_profile,
+         long size,
+         struct targets* p_targets)
+{
+    char value[256];
+    uint32_t seed = 12345; /* Fixed LCG, files are identical on every run */
+    FILE* file = fopen(filename, "w");
+    assert(file != NULL);
+
+    /* Fixed number of sections share the keys evenly */
+    long line_len = 16 + p_profile->value_len;
+    int per_section = p_profile->keys_per_section;
+    if (p_profile->sections > 0) per_section = (int)(size / line_len / p_profile->sections) + 1;
+
+    long written = 0;
+    int section = -1, key = 0;
+    for (int n = 0; written < size; ++n, ++key) {
+        if (n % per_section == 0) {
+            written += fprintf(file, "%s[section_%d]\n", n ? "\n" : "", ++section);
+            key = 0;
+        }
+        for (int i = 0; i < p_profile->value_len; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            value[i] = "abcdefghijklmnopqrstuvwxyz0123456789"[(seed >> 16) % 36];
+        }
+        value[p_profile->value_len] = '\0';
+        if (p_profile->quoted) written += fprintf(file, "key_%d = \"%.*s\\\\%s \\\"q\\\"\"\n", key, p_profile->value_len / 2, value, value + p_profile->value_len / 2);
+        else written += fprintf(file, "key_%d = %s\n", key, value);
+
+        /* Remember first, middle and last key */
+        char (*p_target)[BENCH_NAME_LEN] = p_targets->last;
+        if (n == 0) p_target = p_targets->first;
+        else if (written >= size / 2 && p_targets->middle[0][0] == '\0') p_target = p_targets->middle;
+        snprintf(p_target[0], BENCH_NAME_LEN, "section_%d", section);
+        snprintf(p_target[1], BENCH_NAME_LEN, "key_%d", key);
+    }
+    fclose(file);
+    return written;
+}
+
+/* One measured operation, i is the iteration */
+typedef int (*bench_fn)(const struct targets* p_targets, long i);
+
+static const char (*target_key)[BENCH_NAME_LEN];
+static ini_doc_t* doc;
+
+static int
+op_read_cold(const struct targets* p_targets, long i)
+{
+    char buffer[512];
+    (void)p_targets; (void)i;
+    ini_cache_flush();
+    return ini_read_key(BENCH_FILE, target_key[0], target_key[1], buffer, sizeof(buffer));
+}
+
+static int
+op_read_cached(const struct targets* p_targets, long i)
+{
+    char buffer[512];
+    (void)p_targets; (void)i;
+    return ini_read_key(BENCH_FILE, target_key[0], target_key[1], buffer, sizeof(buffer));
+}
+
+static int
+op_batch(const struct targets* p_targets, long i)
+{
+    char values[3][512];
+    ini_query_t query[3] = {
+        { p_targets->first[0], p_targets->first[1], values[0], sizeof(values[0]), 0 },
+        { p_targets->middle[0], p_targets->middle[1], values[1], sizeof(values[1]), 0 },
+        { p_targets->last[0], p_targets->last[1], values[2], sizeof(values[2]), 0 },
+    };
+    (void)i;
+    ini_cache_flush();
+    return ini_read_keys(BENCH_FILE, query, 3) == 3 ? 0 : -1;
+}
+
+static int
+op_open(const struct targets* p_targets, long i)
+{
+    ini_doc_t* p_doc = NULL;
+    (void)p_targets; (void)i;
+    int result = ini_open(BENCH_FILE, &p_doc);
+    ini_close(p_doc);
+    return result;
+}
+
+static int
+op_get(const struct targets* p_targets, long i)
+{
+    char buffer[512];
+    (void)p_targets; (void)i;
+    return ini_get(doc, target_key[0], target_key[1], buffer, sizeof(buffer));
+}
+
+static int
+op_write_insert(const struct targets* p_targets, long i)
+{
+    char key[BENCH_NAME_LEN];
+    snprintf(key, sizeof(key), "bench_insert_%ld", i);
+    return ini_write_key(BENCH_FILE, p_targets->middle[0], key, "inserted", NULL);
+}
+
+static int
+op_write_update(const struct targets* p_targets, long i)
+{
+    (void)i;
+    return ini_write_key(BENCH_FILE, p_targets->middle[0], p_targets->middle[1], i % 2 ? "updated_a" : "updated_b", NULL);
+}
+
+static int
+op_write_section(const struct targets* p_targets, long i)
+{
+    char section[BENCH_NAME_LEN];
+    (void)p_targets;
+    snprintf(section, sizeof(section), "bench_section_%ld", i);
+    return ini_write_key(BENCH_FILE, section, "key", "new", NULL);
+}
+
+static void
+measure(const char* p_op,
+        const char* p_where,
+        bench_fn fn,
+        const struct profile* p_profile,
+        const struct targets* p_targets,
+        long size,
+        double budget)
+{
+    /* Warm up once, then repeat until the time budget is spent */
+    int result = fn(p_targets, 0);
+    assert(result >= 0);
+    long ops = 0;
+    unsigned long alloc_start = atomic_load(&allocs);
+    double start = now(), elapsed;
+    do {
+        result = fn(p_targets, ++ops);
+        assert(result >= 0);
+    } while ((elapsed = now() - start) < budget);
+    (void)result;
+    unsigned long alloc_count = atomic_load(&allocs) - alloc_start;
+
+    printf("{\"op\":\"%s\",\"key\":\"%s\",\"profile\":\"%s\",\"bytes\":%ld,\"ops\":%ld,"
+           "\"ns_op\":%.1f,\"mb_s\":%.2f,\"allocs_op\":%.2f}\n",
+           p_op, p_where, p_profile->p_name, size, ops,
+           elapsed * 1e9 / ops, size / 1e6 * ops / elapsed, (double)alloc_count / ops);
+    fflush(stdout);
+}
+
+int main(void) {
+    const char* p_max = getenv("INI_BENCH_MAX");
+    const char* p_time = getenv("INI_BENCH_TIME");
+    long max_size = p_max ? atol(p_max) : sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+    double budget = p_time ? atof(p_time) : BENCH_TIME;
+    char image[64];
+    snprintf(image, sizeof(image), "%s.bin", BENCH_FILE);
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && sizes[s] <= max_size; ++s) {
+        for (size_t p = 0; p < sizeof(profiles) / sizeof(profiles[0]); ++p) {
+            const struct profile* p_profile = &profiles[p];
+            struct targets targets;
+            memset(&targets, 0, sizeof(targets));
+            long size = generate(BENCH_FILE, p_profile, sizes[s], &targets);
+
+            /* File API, cold parses and cache hits */
+            const char (*keys[3])[BENCH_NAME_LEN] = { targets.first, targets.middle, targets.last };
+            const char* p_where[3] = { "first", "middle", "last" };
+            for (int k = 0; k < 3; ++k) {
+                target_key = keys[k];
+                measure("read_key_cold", p_where[k], op_read_cold, p_profile, &targets, size, budget);
+                measure("read_key_cached", p_where[k], op_read_cached, p_profile, &targets, size, budget);
+            }
+            measure("read_keys_batch", "all", op_batch, p_profile, &targets, size, budget);
+
+            /* Handle API, parsed and from a compiled image */
+            measure("open_close", "-", op_open, p_profile, &targets, size, budget);
+            assert(ini_open(BENCH_FILE, &doc) == 0);
+            target_key = targets.middle;
+            measure("get", "middle", op_get, p_profile, &targets, size, budget);
+            ini_close(doc);
+            if (ini_compile(BENCH_FILE, NULL) == 0) {
+                measure("open_close_image", "-", op_open, p_profile, &targets, size, budget);
+                remove(image);
+            }
+
+            /* Writes rewrite the whole file */
+            measure("write_update", "middle", op_write_update, p_profile, &targets, size, budget);
+            measure("write_insert", "middle", op_write_insert, p_profile, &targets, size, budget);
+            measure("write_section", "end", op_write_section, p_profile, &targets, size, budget);
+            ini_cache_flush();
+            remove(BENCH_FILE);
+        }
+    }
+    return 0;
+}
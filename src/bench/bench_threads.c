@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * @file      bench_threads.c
+ * @author    Peter Hillerström <prohstream@gmail.com>
+ * @copyright 2025, Peter Hillerström
+ * @license   MIT
+ * @date      16 oct 2026
+ ****************************************************************************/
+/**
+ * @brief     Multi-threaded read stress benchmark
+ * @details   1 to 64 threads hammer reads on one shared document with
+ *            ini_get() and through the parse cache with ini_read_key().
+ *            Reports total ops/sec per thread count.
+ ****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "../ini.h"
+
+#define BENCH_FILE     "./build/bench_threads.ini"
+#define BENCH_SECTIONS (100)
+#define BENCH_KEYS     (20)
+#define BENCH_SECONDS  (0.2)
+#define BENCH_THREADS  (64)
+
+static ini_doc_t* doc;
+static atomic_int running;
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void*
+read_doc(void* p_arg)
+{
+    unsigned long* p_ops = p_arg, ops = 0, rnd = (unsigned long)(uintptr_t)p_arg;
+    char section[32], key[32], value[64];
+    while (atomic_load_explicit(&running, memory_order_relaxed)) {
+        rnd = rnd * 6364136223846793005UL + 1442695040888963407UL;
+        snprintf(section, sizeof(section), "section_%lu", (rnd >> 33) % BENCH_SECTIONS);
+        snprintf(key, sizeof(key), "key_%lu", (rnd >> 45) % BENCH_KEYS);
+        int result = doc ? ini_get(doc, section, key, value, sizeof(value))
+                         : ini_read_key(BENCH_FILE, section, key, value, sizeof(value));
+        assert(result > 0);
+        ++ops;
+    }
+    *p_ops = ops;
+    return NULL;
+}
+
+static void
+run(const char* p_name,
+    int threads)
+{
+    pthread_t thread[BENCH_THREADS];
+    unsigned long ops[BENCH_THREADS], total = 0;
+
+    atomic_store(&running, 1);
+    for (int i = 0; i < threads; ++i) assert(pthread_create(&thread[i], NULL, read_doc, &ops[i]) == 0);
+    double start = now();
+    nanosleep(&(struct timespec){ 0, (long)(BENCH_SECONDS * 1e9) }, NULL);
+    atomic_store(&running, 0);
+    for (int i = 0; i < threads; ++i) { pthread_join(thread[i], NULL); total += ops[i]; }
+    double elapsed = now() - start;
+    printf("%-24s %3d threads  %12.0f ops/s\n", p_name, threads, total / elapsed);
+}
+
+int main(void) {
+    FILE* file = fopen(BENCH_FILE, "w");
+    assert(file != NULL);
+    for (int s = 0; s < BENCH_SECTIONS; ++s) {
+        fprintf(file, "[section_%d]\n", s);
+        for (int k = 0; k < BENCH_KEYS; ++k) fprintf(file, "key_%d = value %d\n", k, s * k);
+    }
+    fclose(file);
+
+    assert(ini_open(BENCH_FILE, &doc) == 0);
+    for (int threads = 1; threads <= BENCH_THREADS; threads *= 2) run("ini_get shared doc", threads);
+    ini_close(doc);
+    doc = NULL;
+    for (int threads = 1; threads <= BENCH_THREADS; threads *= 2) run("ini_read_key cached", threads);
+    remove(BENCH_FILE);
+    return 0;
+}
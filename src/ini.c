@@ -5,6 +5,9 @@
  * @license   MIT
  * @date      7 jun 2025
  ****************************************************************************/
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* O_TMPFILE and linkat() flags, before any system header */
+#endif
 #include "ini.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -12,22 +15,81 @@
 #include <string.h>
 #include <time.h>
 #include <errno.h>
+#include <math.h>
+#include <locale.h>
+#include <stdatomic.h>
+#include <limits.h>
 #if defined(_WIN32) || defined(_WIN64)
 #include <windows.h>
 #include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #else
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sched.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+#endif
+#if !defined(INI_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define INI_SIMD_X86 (1)
+#include <immintrin.h>
 #endif
 
 #define INI_VERSION_MAJOR (01)
 #define INI_VERSION_MINOR (00)
 #define INI_VERSION_BUILD (0000)
 
-#define MAX_LINE_LENGTH (256)
-#define INI_TMP_NAME_LEN (256)
+#define INI_LINE_INLINE (256) /* Lines up to this size need no heap */
+#define INI_CACHE_LIMIT (16 * 1024 * 1024) /* Default parse cache size in bytes */
+#define INI_WATCH_POLL_MS (500) /* Change check interval without inotify */
+#define INI_ERROR_LEN     (128) /* Per-thread errno message buffer */
+#ifndef PATH_MAX
+#define PATH_MAX         (4096)
+#endif
+#define INI_TMP_NAME_LEN (PATH_MAX + 32) /* Target path and ".<pid>.<hex>.tmp" */
+#define INI_TMP_RETRIES  (16) /* Temp names tried before giving up */
+#define INI_WRITE_RETRIES (8) /* Rewrites before giving up on a file changed by unlocked writers */
+#define INI_ARENA_BLOCK   (4096)        /* First arena block, later ones double up to INI_ARENA_MAX */
+#define INI_ARENA_MAX     (1024 * 1024)
+#define INI_PARSE_CHUNK   (1024 * 1024) /* Smallest share of a mapped file per parse thread */
+#define INI_PARSE_THREADS (64)          /* Parse threads at most */
+
+#define INI_HASH_OFFSET (0xcbf29ce484222325ULL) /* FNV-1a 64 bit */
+#define INI_HASH_PRIME  (0x100000001b3ULL)
+#define INI_NO_ENTRY    ((size_t)-1)
+#define INI_NO_TOKEN    ((size_t)-1)
+
+#define INI_KIND_BLANK    (0) /* Line kinds from ini_split_line() */
+#define INI_KIND_COMMENT  (1)
+#define INI_KIND_SECTION  (2)
+#define INI_KIND_KEY      (3)
+#define INI_KIND_QUOTED   (4) /* Key with quoted value, still encoded */
+#define INI_KIND_BAD      (5)
+
+#define INI_CONV_NONE     (0) /* Typed conversion cache state of an entry */
+#define INI_CONV_BUSY     (1)
+#define INI_CONV_INT      (2)
+#define INI_CONV_DOUBLE   (3)
+#define INI_CONV_BOOL     (4)
+#define INI_CONV_DURATION (5)
+
+#define INI_IMAGE_MAGIC   "INI.BIN"     /* Compiled image, see ini_compile() */
+#define INI_IMAGE_VERSION (2)
+#define INI_IMAGE_ORDER   (0x01020304)  /* Images are only valid in host byte order */
+#define INI_IMAGE_NONE    (0xFFFFFFFFu) /* Empty perfect hash slot */
+#define INI_IMAGE_TRIES   (1u << 20)    /* Displacements tried per perfect hash bucket */
 
 #define TOLOWER(x) ((x) >= 'A' && (x) <= 'Z' ? (x) + ('a' - 'A') : (x))
 #define ISSPACE(x) ((x) == ' ' || (x) == '\t')
+#define ISDIGIT(x) ((x) >= '0' && (x) <= '9')
+#define ISALPHA(x) (TOLOWER(x) >= 'a' && TOLOWER(x) <= 'z')
 #define ISCOMMENT(x) ((x) == ';' || (x) == '#')
 
 #define RET_OK       (0)
@@ -38,10 +100,69 @@
 #define RET_BUF      (-5)
 #define RET_FMT      (-6)
 #define RET_TMPEXIST (-7)
+#define RET_CHANGED  (-8)
+#define RET_NOSUP    (-13)
 #define ERRNO_OFFSET (1000)
 #define RET_ERRNO (-(errno + ERRNO_OFFSET))
 #define RET_ERRVAL(x) (-(x + ERRNO_OFFSET))
 
+#ifdef INI_STATS
+/* Instrumentation, relaxed atomics so any thread may count */
+struct ini_latency_counters {
+    atomic_ullong count;
+    atomic_ullong total_ns;
+    atomic_ullong buckets[INI_STATS_BUCKETS];
+};
+
+static struct {
+    atomic_ullong files_opened;
+    atomic_ullong lines_scanned;
+    atomic_ullong bytes_read;
+    atomic_ullong bytes_written;
+    atomic_ullong temp_files;
+    atomic_ullong renames;
+    atomic_ullong cache_hits;
+    atomic_ullong cache_misses;
+    struct ini_latency_counters read_key;
+    struct ini_latency_counters open;
+    struct ini_latency_counters get;
+    struct ini_latency_counters commit;
+} ini_stats;
+
+static uint64_t
+ini_stats_now(void)
+{
+    struct timespec ts;
+#if defined(_WIN32) || defined(_WIN64)
+    timespec_get(&ts, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void
+ini_stats_record(struct ini_latency_counters* p_latency,
+                 uint64_t start)
+{
+    /* Bucket i holds latencies in [2^i, 2^(i+1)) ns */
+    uint64_t ns = ini_stats_now() - start;
+    int bucket = 63 - __builtin_clzll(ns | 1);
+    if (bucket >= INI_STATS_BUCKETS) bucket = INI_STATS_BUCKETS - 1;
+    atomic_fetch_add_explicit(&p_latency->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&p_latency->total_ns, ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&p_latency->buckets[bucket], 1, memory_order_relaxed);
+}
+
+#define INI_STAT_ADD(field, n)     atomic_fetch_add_explicit(&ini_stats.field, (uint64_t)(n), memory_order_relaxed)
+#define INI_STAT_START(var)        uint64_t var = ini_stats_now()
+#define INI_STAT_TIME(field, var)  ini_stats_record(&ini_stats.field, var)
+#else
+#define INI_STAT_ADD(field, n)     ((void)0)
+#define INI_STAT_START(var)        ((void)0)
+#define INI_STAT_TIME(field, var)  ((void)0)
+#endif
+
 LIB_EXPORT int
 ini_version() 
 {
@@ -53,8 +174,20 @@ ini_version()
 LIB_EXPORT const char*
 ini_error_string(int err) 
 {
+    /* Per-thread buffer, strerror() may share a static one */
+    static _Thread_local char buffer[INI_ERROR_LEN];
+
     if (err >= 0) return "No Error"; /* Success or valid data */
-    if (err <= -ERRNO_OFFSET) return strerror(-err - ERRNO_OFFSET); /* errno error */
+    if (err <= -ERRNO_OFFSET) { /* errno error */
+#if defined(_WIN32) || defined(_WIN64)
+        if (strerror_s(buffer, sizeof(buffer), -err - ERRNO_OFFSET) != 0) return "Unknown Error";
+#elif defined(__GLIBC__) && defined(_GNU_SOURCE)
+        return strerror_r(-err - ERRNO_OFFSET, buffer, sizeof(buffer)); /* GNU variant */
+#else
+        if (strerror_r(-err - ERRNO_OFFSET, buffer, sizeof(buffer)) != 0) return "Unknown Error";
+#endif
+        return buffer;
+    }
     switch (err) { /* Local defined errors */
         case RET_ERR:      return "An Error Occurred";
         case RET_NULL:     return "NULL Pointer Error";
@@ -63,9 +196,70 @@ ini_error_string(int err)
         case RET_BUF:      return "Buffer Full";
         case RET_FMT:      return "Format Error";
         case RET_TMPEXIST: return "Temp File Exist";
+        case RET_CHANGED:  return "File Changed During Write";
+        case RET_NOSUP:    return "Not Supported";
         default:       return "Unknown Error";}
 }
 
+#ifdef INI_STATS
+static void
+ini_stats_copy(ini_latency_t* p_dest,
+               struct ini_latency_counters* p_src,
+               int reset)
+{
+    p_dest->count = reset ? atomic_exchange(&p_src->count, 0) : atomic_load(&p_src->count);
+    p_dest->total_ns = reset ? atomic_exchange(&p_src->total_ns, 0) : atomic_load(&p_src->total_ns);
+    for (int i = 0; i < INI_STATS_BUCKETS; ++i) {
+        p_dest->buckets[i] = reset ? atomic_exchange(&p_src->buckets[i], 0) : atomic_load(&p_src->buckets[i]);
+    }
+}
+#endif
+
+LIB_EXPORT int
+ini_stats_get(ini_stats_t* p_stats)
+{
+    if (!p_stats) return RET_NULL;
+    memset(p_stats, 0, sizeof(*p_stats));
+#ifdef INI_STATS
+    /* Each counter is read atomically, the snapshot as a whole is not */
+    p_stats->files_opened = atomic_load(&ini_stats.files_opened);
+    p_stats->lines_scanned = atomic_load(&ini_stats.lines_scanned);
+    p_stats->bytes_read = atomic_load(&ini_stats.bytes_read);
+    p_stats->bytes_written = atomic_load(&ini_stats.bytes_written);
+    p_stats->temp_files = atomic_load(&ini_stats.temp_files);
+    p_stats->renames = atomic_load(&ini_stats.renames);
+    p_stats->cache_hits = atomic_load(&ini_stats.cache_hits);
+    p_stats->cache_misses = atomic_load(&ini_stats.cache_misses);
+    ini_stats_copy(&p_stats->read_key, &ini_stats.read_key, 0);
+    ini_stats_copy(&p_stats->open, &ini_stats.open, 0);
+    ini_stats_copy(&p_stats->get, &ini_stats.get, 0);
+    ini_stats_copy(&p_stats->commit, &ini_stats.commit, 0);
+    return RET_OK;
+#else
+    return RET_NOSUP;
+#endif
+}
+
+LIB_EXPORT void
+ini_stats_reset(void)
+{
+#ifdef INI_STATS
+    ini_latency_t discard;
+    atomic_store(&ini_stats.files_opened, 0);
+    atomic_store(&ini_stats.lines_scanned, 0);
+    atomic_store(&ini_stats.bytes_read, 0);
+    atomic_store(&ini_stats.bytes_written, 0);
+    atomic_store(&ini_stats.temp_files, 0);
+    atomic_store(&ini_stats.renames, 0);
+    atomic_store(&ini_stats.cache_hits, 0);
+    atomic_store(&ini_stats.cache_misses, 0);
+    ini_stats_copy(&discard, &ini_stats.read_key, 1);
+    ini_stats_copy(&discard, &ini_stats.open, 1);
+    ini_stats_copy(&discard, &ini_stats.get, 1);
+    ini_stats_copy(&discard, &ini_stats.commit, 1);
+#endif
+}
+
 static int
 ini_write_header(FILE* file)
 {
@@ -78,7 +272,7 @@ ini_write_header(FILE* file)
     if (fprintf(file, "# Inline comments after values are allowed.\n") < 0) return RET_ERRNO; 
     if (fprintf(file, "# Values after '=' are treated as strings and trimmed from whitespace.\n") < 0) return RET_ERRNO; 
     if (fprintf(file, "# For example: key = \"A value\" is the same as key = A value\n") < 0) return RET_ERRNO; 
-    if (fprintf(file, "# Inside quotes (\") you may use escape sequences: \\\\ \\\" \\n \\r \\t.\n") < 0) return RET_ERRNO; 
+    if (fprintf(file, "# Inside quotes (\") you may use escape sequences: \\\\ \\\" \\' \\n \\r \\t \\xNN.\n") < 0) return RET_ERRNO; 
     if (fprintf(file, "# Section and key names are case-insensitive. Arrays are not supported.\n") < 0) return RET_ERRNO; 
     if (fprintf(file, "# https://en.wikipedia.org/wiki/INI_file\n") < 0) return RET_ERRNO; 
     if (fprintf(file, "\n") < 0) return RET_ERRNO; 
@@ -86,52 +280,155 @@ ini_write_header(FILE* file)
 }
 
 static int
-ini_temp_file(char* p_filename,
+ini_temp_file(const char* filename,
+              char* p_filename,
               size_t filename_size)
 {
-    if (!p_filename) return RET_NULL; // Null pointer
+    if (!filename || !p_filename) return RET_NULL; // Null pointer
 
 #if defined(_WIN32) || defined(_WIN64)
-    /* Get Temp Path */
-    char p_dir[MAX_PATH];
-    if (!GetTempPathA(sizeof(p_dir), p_dir)) return RET_ERR;
-
     /* Get PID */
     unsigned int pid = (unsigned int)GetCurrentProcessId();
-#else  
-    /* Get Temp Path */
-    const char* p_dir = "/tmp/";
-
+#else
     /* Get PID */
     unsigned int pid = (unsigned int)getpid();
 #endif
 
-    /* Generate a random number */
-    srand((unsigned)time(NULL) ^ pid);
-    unsigned int rnd_val = (unsigned int)rand();
+    /* Unique suffix without shared PRNG state: time, call counter and stack address */
+    static atomic_uint counter;
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    unsigned int rnd_val = (unsigned int)ts.tv_nsec ^ (unsigned int)ts.tv_sec
+                         ^ (atomic_fetch_add(&counter, 1) * 0x9E3779B9u)
+                         ^ (unsigned int)(uintptr_t)&ts;
 
-    /* Generate path + filename */
-    int result = snprintf(p_filename, filename_size, "%sini-%u.%08X.tmp", p_dir, pid, rnd_val);
+    /* Next to the target so the rename never crosses file systems */
+    int result = snprintf(p_filename, filename_size, "%s.%u.%08X.tmp", filename, pid, rnd_val);
     if (result < 0) return RET_FMT;
     if ((size_t)result >= filename_size) return RET_BUF;
+    return 0;
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+static int
+ini_path_dir(const char* filename,
+             char* p_dir,
+             size_t dir_size)
+{
+    /* "file" is in ".", "/file" in "/" */
+    const char* p_slash = strrchr(filename, '/');
+    size_t len = p_slash ? (size_t)(p_slash - filename) : 1;
+    if (p_slash && len == 0) len = 1;
+    if (len >= dir_size) return RET_BUF;
+    memcpy(p_dir, p_slash ? filename : ".", len);
+    p_dir[len] = '\0';
+    return RET_OK;
+}
+
+static int
+ini_sync_dir(const char* filename)
+{
+    char dir[INI_TMP_NAME_LEN];
+    int result = ini_path_dir(filename, dir, sizeof(dir));
+    if (result < 0) return result;
+    int fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return RET_ERRNO;
+    result = fsync(fd) == 0 ? RET_OK : RET_ERRNO;
+    close(fd);
+    return result;
+}
+#endif
+
+static int
+ini_temp_open(const char* filename,
+              int mode,
+              char* p_temp_name,
+              size_t temp_size,
+              FILE** p_file)
+{
+    int fd = -1, result;
+
+    /* An unnamed file leaves nothing behind on a crash, ini_temp_link() names it */
+    p_temp_name[0] = '\0';
+#if defined(O_TMPFILE)
+    char dir[INI_TMP_NAME_LEN];
+    if (ini_path_dir(filename, dir, sizeof(dir)) == RET_OK) fd = open(dir, O_TMPFILE | O_WRONLY | O_CLOEXEC, mode);
+#endif
 
-    /* Check if file exist (Not good) */
+    /* Exclusive create of a fresh name, no check-then-open race */
+    for (int i = 0; fd < 0 && i < INI_TMP_RETRIES; ++i) {
+        if ((result = ini_temp_file(filename, p_temp_name, temp_size)) < 0) return result;
 #if defined(_WIN32) || defined(_WIN64)
-    if (_access(p_filename, 0) == 0) return RET_TMPEXIST;
-#else  
-    if (access(p_filename, F_OK) == 0) return RET_TMPEXIST;
+        fd = _open(p_temp_name, _O_WRONLY | _O_CREAT | _O_EXCL | _O_TEXT, _S_IREAD | _S_IWRITE);
+#else
+        fd = open(p_temp_name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode);
 #endif
-    return 0;
-}   
+        if (fd < 0 && errno != EEXIST) { result = RET_ERRNO; p_temp_name[0] = '\0'; return result; }
+    }
+    if (fd < 0) { p_temp_name[0] = '\0'; return RET_TMPEXIST; }
+
+#if defined(_WIN32) || defined(_WIN64)
+    (void)mode;
+    *p_file = _fdopen(fd, "w");
+    if (!*p_file) { result = RET_ERRNO; _close(fd); return result; }
+#else
+    /* Same permissions as the file it replaces, without the umask */
+    if (fchmod(fd, (mode_t)mode) != 0) { result = RET_ERRNO; close(fd); return result; }
+    *p_file = fdopen(fd, "w");
+    if (!*p_file) { result = RET_ERRNO; close(fd); return result; }
+#endif
+    INI_STAT_ADD(temp_files, 1);
+    return RET_OK;
+}
+
+#if defined(O_TMPFILE)
+static int
+ini_temp_link(FILE* file,
+              const char* filename,
+              char* p_temp_name,
+              size_t temp_size)
+{
+    char fd_path[32];
+    int result = RET_TMPEXIST;
+    snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", fileno(file));
+
+    /* Name the unnamed file, the name is then renamed over the target */
+    for (int i = 0; i < INI_TMP_RETRIES; ++i) {
+        if ((result = ini_temp_file(filename, p_temp_name, temp_size)) < 0) break;
+        if (linkat(AT_FDCWD, fd_path, AT_FDCWD, p_temp_name, AT_SYMLINK_FOLLOW) == 0) return RET_OK;
+        if (errno == ENOENT && linkat(fileno(file), "", AT_FDCWD, p_temp_name, AT_EMPTY_PATH) == 0) return RET_OK;
+        result = errno == EEXIST ? RET_TMPEXIST : RET_ERRNO;
+        if (result != RET_TMPEXIST) break;
+    }
+    p_temp_name[0] = '\0';
+    return result;
+}
+#endif
+
+static int
+ini_sync_file(FILE* file)
+{
+    if (fflush(file) != 0) return RET_ERRNO;
+#if defined(_WIN32) || defined(_WIN64)
+    if (!FlushFileBuffers((HANDLE)_get_osfhandle(_fileno(file)))) return RET_ERR;
+#else
+    if (fdatasync(fileno(file)) != 0) return RET_ERRNO;
+#endif
+    return RET_OK;
+}
 
 static int 
 ini_replace_file(const char *temp_name,
-                 const char *filename) 
+                 const char *filename,
+                 unsigned options) 
 {
 #if defined(_WIN32) || defined(_WIN64)
-    if (!MoveFileExA(temp_name, filename, MOVEFILE_REPLACE_EXISTING))
+    DWORD flags = MOVEFILE_REPLACE_EXISTING;
+    if (options & INI_WRITE_SYNC_DIR) flags |= MOVEFILE_WRITE_THROUGH;
+    if (!MoveFileExA(temp_name, filename, flags))
         return RET_ERRNO;
 #else
+    (void)options; /* The caller syncs the directory */
     if (rename(temp_name, filename) != 0)
         return RET_ERRNO;
 #endif
@@ -154,53 +451,124 @@ ini_writeln(FILE* file,
 
 static int
 ini_writef(FILE* file,
-          const char *fmt,
-          ...) 
+           const char* p_eol,
+           const char *fmt,
+           ...) 
 {
-    /* Print buffer */
-    char buffer[MAX_LINE_LENGTH];
-    
-    /* Print the formatted string */
+    /* Print the formatted string directly, no length limit */
     va_list args;
     va_start(args, fmt);
-    int len = vsnprintf(buffer, MAX_LINE_LENGTH - 1, fmt, args);
+    int len = vfprintf(file, fmt, args);
     int errval = errno;
     va_end(args);
 
     if (len < 0) return RET_ERRVAL(errval); /* Write error */
-    
-    /* Null terminate for secure string */
-    buffer[MAX_LINE_LENGTH - 1] = '\0';
+    if (fputs(p_eol, file) == EOF) return RET_ERRNO;
+
+    return len + (int)strlen(p_eol);
+}
+
+/* Growable line buffer, short lines stay in the inline buffer */
+struct ini_line {
+    char* p_buf;        /* Inline buffer or heap */
+    size_t size;
+    size_t len;
+    char inline_buf[INI_LINE_INLINE];
+};
+
+static void
+ini_line_init(struct ini_line* p_line)
+{
+    p_line->p_buf = p_line->inline_buf;
+    p_line->size = sizeof(p_line->inline_buf);
+    p_line->len = 0;
+    p_line->p_buf[0] = '\0';
+}
 
-    return ini_writeln(file, buffer);
+static void
+ini_line_free(struct ini_line* p_line)
+{
+    if (p_line->p_buf != p_line->inline_buf) free(p_line->p_buf);
+    ini_line_init(p_line);
+}
+
+static int
+ini_line_reserve(struct ini_line* p_line,
+                 size_t size)
+{
+    if (size <= p_line->size) return RET_OK;
+
+    /* Double until it fits, the buffer is kept for following lines */
+    size_t new_size = p_line->size * 2;
+    while (new_size < size) new_size *= 2;
+    char* p_buf = p_line->p_buf == p_line->inline_buf ? malloc(new_size) : realloc(p_line->p_buf, new_size);
+    if (!p_buf) return RET_ERRNO;
+    if (p_line->p_buf == p_line->inline_buf) memcpy(p_buf, p_line->inline_buf, p_line->len + 1);
+    p_line->p_buf = p_buf;
+    p_line->size = new_size;
+    return RET_OK;
+}
+
+static int
+ini_line_set(struct ini_line* p_line,
+             const char* p_str,
+             size_t len)
+{
+    int result = ini_line_reserve(p_line, len + 1);
+    if (result < 0) return result;
+    memcpy(p_line->p_buf, p_str, len);
+    p_line->p_buf[len] = '\0';
+    p_line->len = len;
+    return RET_OK;
 }
 
 static int
 ini_readln(FILE* file,
-           char* p_buf,
-           size_t buf_len)
+           struct ini_line* p_line)
 {
-    if (!file || !p_buf || buf_len == 0) {
+    if (!file || !p_line) {
         return RET_NULL; /* Invalid parameters */
     }
 
-    /* Read Line */
-    if (fgets(p_buf, buf_len, file) == NULL) {
-        int errval = errno;
-        if (feof(file)) return RET_EOF;
-        return RET_ERRVAL(errval);
+    /* Read chunks until newline or EOF, growing the buffer as needed */
+    p_line->len = 0;
+    for (;;) {
+        if (fgets(p_line->p_buf + p_line->len, (int)(p_line->size - p_line->len), file) == NULL) {
+            int errval = errno;
+            if (ferror(file)) return RET_ERRVAL(errval);
+            if (p_line->len == 0) return RET_EOF;
+            break; /* Last line without newline */
+        }
+        p_line->len += strlen(p_line->p_buf + p_line->len);
+        if (p_line->len > 0 && p_line->p_buf[p_line->len - 1] == '\n') break;
+        if (p_line->len < p_line->size - 1) break; /* EOF without newline */
+        int result = ini_line_reserve(p_line, p_line->size * 2);
+        if (result < 0) return result;
     }
 
-    /* Remove trailing newlines character if present */
-    size_t len = strcspn(p_buf, "\r\n");
-    p_buf[len] = '\0';
+    /* Remove the trailing newline, a CR before it goes too, like the mapped reader */
+    size_t len = p_line->len;
+    if (len > 0 && p_line->p_buf[len - 1] == '\n') --len;
+    if (len > 0 && p_line->p_buf[len - 1] == '\r') --len;
+    p_line->p_buf[len] = '\0';
+    p_line->len = len;
+    if (len > INT32_MAX) return RET_BUF;
 
     return (int) len; // Return the length of the line read
 }
 
 
+static inline int
+ini_hex_digit(char c)
+{
+    if (ISDIGIT(c)) return c - '0';
+    c = (char)TOLOWER(c);
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
 static int
 ini_parse_value(const char* p_src,
+                size_t src_len,
                 char* p_dest,
                 size_t dest_len)
 {
@@ -209,41 +577,50 @@ ini_parse_value(const char* p_src,
     size_t i_src = 0, i_dest = 0;
 
     // Skip leading whitespace
-    while (ISSPACE(p_src[i_src])) ++i_src;
+    while (i_src < src_len && ISSPACE(p_src[i_src])) ++i_src;
 
     /* Start parsing value string */
-    if (p_src[i_src] == '"') { // Quoted string
-        int escape_flag = 0;
-        
-        /* Scan value */
-        for (i_src += 1; p_src[i_src] /* EoS */ && i_dest < dest_len - 1; ++i_src) 
-        {
-            /* Check for escape sequencies */
-            if (escape_flag) { // If we are in escape sequence 
-                escape_flag = 0; // Reset escape flag
-                switch (p_src[i_src]) {
-                    case 'n': p_dest[i_dest++] = '\n'; break;
-                    case 't': p_dest[i_dest++] = '\t'; break;
-                    case 'r': p_dest[i_dest++] = '\r'; break;
-                    case '\\': p_dest[i_dest++] = '\\'; break;
-                    case '"': p_dest[i_dest++] = '"'; break;
-                    // Add more escape sequences as needed
-                    default: 
-                        p_dest[i_dest++] = '\\'; /* Unknown escape seq add the '\' to output */ 
-                        if (i_dest < dest_len) p_dest[i_dest++] = p_src[i_src]; 
+    if (i_src < src_len && p_src[i_src] == '"') { // Quoted string
+        const char* p_end = p_src + src_len;
+        const char* p = p_src + i_src + 1;
+        const char* p_quote = memchr(p, '"', (size_t)(p_end - p));
+        const char* p_esc = memchr(p, '\\', (size_t)(p_end - p));
+
+        for (;;) {
+            /* Copy the run up to the next quote or backslash in one go */
+            const char* p_stop = p_esc && (!p_quote || p_esc < p_quote) ? p_esc : p_quote;
+            size_t run = (size_t)((p_stop ? p_stop : p_end) - p);
+            if (run > dest_len - 1 - i_dest) run = dest_len - 1 - i_dest;
+            memcpy(p_dest + i_dest, p, run);
+            i_dest += run;
+            p += run;
+            if (p != p_stop || p == p_quote) break; /* End quote, end of source or output full */
+            if (p + 1 == p_end || i_dest == dest_len - 1) break; /* Dangling '\' */
+
+            /* Escape sequence */
+            char c = p[1];
+            p += 2;
+            switch (c) {
+                case 'n': p_dest[i_dest++] = '\n'; break;
+                case 't': p_dest[i_dest++] = '\t'; break;
+                case 'r': p_dest[i_dest++] = '\r'; break;
+                case '\\': p_dest[i_dest++] = '\\'; break;
+                case '"': p_dest[i_dest++] = '"'; break;
+                case '\'': p_dest[i_dest++] = '\''; break;
+                case 'x': /* Malformed ones are kept like unknown escapes */
+                    if (p_end - p >= 2 && ini_hex_digit(p[0]) >= 0 && ini_hex_digit(p[1]) >= 0) {
+                        p_dest[i_dest++] = (char)(ini_hex_digit(p[0]) << 4 | ini_hex_digit(p[1]));
+                        p += 2;
                         break;
-                }
-            }
-            else {
-                /* Check for escape sequencies */
-                if (p_src[i_src] == '\\') {escape_flag = 1; continue; } // Set escape flag
-                
-                /* Check for end quote */
-                else if (p_src[i_src] == '"') break;
-                
-                /* Copy string value to destination */
-                else p_dest[i_dest++] = p_src[i_src];
+                    }
+                    /* fall through */
+                default:
+                    p_dest[i_dest++] = '\\'; /* Unknown escape seq add the '\' to output */
+                    if (i_dest < dest_len - 1) p_dest[i_dest++] = c;
+                    break;
             }
+            if (p_quote && p_quote < p) p_quote = memchr(p, '"', (size_t)(p_end - p));
+            if (p_esc && p_esc < p) p_esc = memchr(p, '\\', (size_t)(p_end - p));
         }
     } else { /* Unquoted string */
         /* White space handling */
@@ -251,7 +628,7 @@ ini_parse_value(const char* p_src,
         size_t i_start = i_src; /* Just for initialization */
         
         /* Scan and copy value until comment or EOL */
-        for (; p_src[i_src] && !ISCOMMENT(p_src[i_src]) && i_dest < dest_len - 1; ++i_src) {
+        for (; i_src < src_len && !ISCOMMENT(p_src[i_src]) && i_dest < dest_len - 1; ++i_src) {
             if (ISSPACE(p_src[i_src])) {
                 if (!whitespace_flag) { 
                     i_start = i_src; // Remember the start of the whitespace
@@ -268,255 +645,3777 @@ ini_parse_value(const char* p_src,
                 p_dest[i_dest++] = p_src[i_src]; 
             }
         }
-        /* Terminate output result */
-        p_dest[i_dest] = '\0';
     }
+    /* Terminate output result */
+    p_dest[i_dest] = '\0';
 
     return (int)i_dest;
 }
 
+/* Bytes of a character inside quotes, 1 for characters copied as they are */
+static const unsigned char ini_escape_len[256] = {
+    [0x00] = 4, 4, 4, 4, 4, 4, 4, 4, 4, 2, 2, 4, 4, 2, 4, 4,
+    [0x10] = 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    [0x20] = 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    [0x30] = 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    [0x40] = 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    [0x50] = 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1,
+    [0x60] = 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    [0x70] = 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 4,
+    [0x80 ... 0xFF] = 1,
+};
+
+static size_t
+ini_encode_size(const char* p_src,
+                size_t len)
+{
+    /* Plain values are written as they are unless they would not read back */
+    if (len > 0 && p_src[0] == '"' && !memchr(p_src, '\n', len) && !memchr(p_src, '\r', len)) {
+        return len; /* Already quoted by the caller, still one line */
+    }
+    int quote = len > 0 && (ISSPACE(p_src[0]) || ISSPACE(p_src[len - 1]));
+    size_t size = 2;
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = (unsigned char)p_src[i];
+        size += ini_escape_len[c];
+        quote |= ini_escape_len[c] > 2 || ISCOMMENT(c) || c == '\n' || c == '\r';
+    }
+    return quote ? size : len;
+}
+
+static size_t
+ini_encode_value(const char* p_src,
+                 size_t len,
+                 char* p_dest)
+{
+    static const char hex[] = "0123456789abcdef";
+    char* p = p_dest;
+
+    /* Quote, copy runs without special characters in one go */
+    *p++ = '"';
+    for (size_t i = 0, start = 0; ; ++i) {
+        if (i < len && ini_escape_len[(unsigned char)p_src[i]] == 1) continue;
+        memcpy(p, p_src + start, i - start);
+        p += i - start;
+        if (i == len) break;
+        start = i + 1;
+        unsigned char c = (unsigned char)p_src[i];
+        *p++ = '\\';
+        switch (c) {
+            case '\n': *p++ = 'n'; break;
+            case '\r': *p++ = 'r'; break;
+            case '\t': *p++ = 't'; break;
+            case '\\': case '"': *p++ = (char)c; break;
+            default: *p++ = 'x'; *p++ = hex[c >> 4]; *p++ = hex[c & 15]; break;
+        }
+    }
+    *p++ = '"';
+    *p = '\0';
+    return (size_t)(p - p_dest);
+}
+
 static int
 ini_write_value(FILE* file,
+                const char* p_eol,
                 const char* p_key,
                 const char* p_value,
                 const char* p_comment)
 {
     if (p_comment) {
-        int result = ini_writef(file, "\n# %s", p_comment);
+        int result = ini_writef(file, p_eol, "%s# %s", p_eol, p_comment);
         if (result < 0) return result;
     }
-    return ini_writef(file, "%s = %s", p_key, p_value);
+    return ini_writef(file, p_eol, "%s = %s", p_key, p_value);
 }
 
-static int
-ini_scan_for_section(FILE* in_file,
-                     char* p_buf,
-                     const char* p_section)
-{ 
-    if (!in_file) return RET_VAL; /* No input file */
+/* Arena block, strings of a document are bump allocated and freed together */
+struct ini_block {
+    struct ini_block* p_next;
+    size_t size;        /* Bytes in data */
+    size_t used;
+    char data[];        /* Header is three words, data is pointer aligned */
+};
 
-    /* Read first line */
-    int len = ini_readln(in_file, p_buf, MAX_LINE_LENGTH);
-    if (len < 0) return len;
+struct ini_arena {
+    struct ini_block* p_head;   /* Allocations are taken from the head block */
+    size_t reserved;            /* Bytes of all blocks */
+    size_t used;
+};
 
-    /* Scan & parse line */
-    int i_buf = 0;
-    int i_section = 0;
+/* Interned name, one per distinct spelling of a section or key */
+struct ini_name {
+    uint64_t hash;              /* Hash of the lowercased name */
+    struct ini_name* p_next;    /* Intern table chain, parse time only */
+    size_t len;
+    char text[];                /* As written, then lowercased, both null terminated */
+};
 
-    /* Skip leading whitespace */
-    while (len - i_buf > 0 && ISSPACE(p_buf[i_buf])) ++i_buf; 
-    if (len - i_buf == 0) return 0;
+/* Document entry, one per key line */
+struct ini_entry {
+    uint64_t hash;      /* Hash of lowercased section and key */
+    size_t next;        /* Next entry in hash chain or INI_NO_ENTRY */
+    const struct ini_name* p_section;
+    const struct ini_name* p_key;
+    char* p_value;      /* Parsed value, in the arena */
+    size_t value_len;   /* Length of parsed value */
+};
 
-    /* Check for section */
-    if (p_buf[i_buf++] != '[') return 0; /* Not a section header */
+/* Document section, one per section header in file order */
+struct ini_section {
+    uint64_t hash;      /* Hash of lowercased name */
+    size_t next;        /* Next section in hash chain or INI_NO_ENTRY */
+    const struct ini_name* p_name;
+    size_t first;       /* First entry of the section */
+    size_t count;       /* Number of entries, entries are contiguous */
+};
 
-    /* Scan for section name */
-    for (; i_buf < len; ++i_buf, ++i_section) {
-            
-        if (p_section[i_section] == '\0') { /* End of Section name */
-            if (p_buf[i_buf] == ']') return i_buf+1; /* Return the index after the ']' character */
-            else return 0; /* Return not found */
-        }
-        else if (TOLOWER(p_buf[i_buf]) != TOLOWER(p_section[i_section])) return 0; /* Return not found */
+/* Identity of a parsed file, used to detect changes */
+struct ini_stamp {
+    uint64_t dev;
+    uint64_t ino;
+    int64_t size;
+    int64_t mtime_sec;
+    long mtime_nsec;
+};
+
+/* Typed value cache of one entry */
+struct ini_conv {
+    atomic_uchar kind;          /* INI_CONV_* of the cached value */
+    atomic_ullong value;        /* Cached value bits */
+};
+
+/* Compiled image header, followed by the tables it points to */
+struct ini_image {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t src_dev;           /* Stamp of the compiled source file */
+    uint64_t src_ino;
+    int64_t src_size;
+    int64_t src_mtime_sec;
+    int64_t src_mtime_nsec;
+    uint64_t image_size;
+    uint32_t entry_count;
+    uint32_t section_count;
+    uint32_t slot_count;        /* Perfect hash slots, power of two */
+    uint32_t disp_count;        /* Perfect hash displacements, power of two */
+    uint32_t entries_off;       /* Offsets from the start of the image */
+    uint32_t sections_off;
+    uint32_t disp_off;
+    uint32_t slots_off;
+    uint32_t strings_off;
+    uint32_t strings_size;
+};
+
+/* Compiled image entry, strings are null terminated in the string pool */
+struct ini_image_entry {
+    uint64_t hash;
+    uint32_t section;
+    uint32_t key_off;
+    uint32_t key_len;
+    uint32_t value_off;
+    uint32_t value_len;
+    uint32_t reserved;
+};
+
+/* Compiled image section, in file order */
+struct ini_image_section {
+    uint64_t hash;
+    uint32_t name_off;
+    uint32_t name_len;
+    uint32_t first;
+    uint32_t count;
+};
+
+/* Parsed document */
+struct ini_doc {
+    struct ini_stamp stamp;     /* Source file, zero if not a regular file */
+    struct ini_arena arena;     /* Names and values */
+    struct ini_name** p_names;  /* Intern table, released once parsed */
+    size_t name_slots;          /* Power of two */
+    size_t name_count;          /* Distinct names */
+    struct ini_entry* p_entries;
+    size_t entry_count;
+    size_t entry_size;
+    size_t* p_buckets;  /* Hash buckets, head entry index */
+    size_t bucket_count;/* Power of two */
+    struct ini_section* p_sections; /* Keys before the first header are in section "" */
+    size_t section_count;
+    size_t section_size;
+    size_t* p_section_buckets;
+    size_t section_bucket_count;
+    struct ini_conv* p_conv;    /* Typed value cache, one per entry */
+    const struct ini_image* p_image; /* Mapped compiled image, replaces the tables above */
+};
+
+static uint64_t
+ini_hash_str(uint64_t hash,
+             const char* p_str,
+             size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char)TOLOWER(p_str[i]);
+        hash *= INI_HASH_PRIME;
     }
+    return hash;
+}
+
+static uint64_t
+ini_hash_key(uint64_t section_hash,
+             const char* p_key,
+             size_t key_len)
+{
+    /* Separator, same as hashing a '\0' */
+    return ini_hash_str(section_hash * INI_HASH_PRIME, p_key, key_len);
+}
+
+static uint64_t
+ini_hash(const char* p_section,
+         size_t section_len,
+         const char* p_key,
+         size_t key_len)
+{
+    return ini_hash_key(ini_hash_str(INI_HASH_OFFSET, p_section, section_len), p_key, key_len);
+}
 
-    return 0; /* Section not found */
+static int
+ini_name_equal(const char* p_a,
+               const char* p_b)
+{
+    for (; *p_a && TOLOWER(*p_a) == TOLOWER(*p_b); ++p_a, ++p_b);
+    return TOLOWER(*p_a) == TOLOWER(*p_b);
 }
 
 static int
-ini_scan_for_key(FILE* in_file,
-                 char* p_buf,
-                 const char* p_key)
+ini_name_equal_n(const char* p_name,
+                 const char* p_span,
+                 int len)
 {
-    if (!in_file) return RET_VAL; /* No input file */
+    for (int i = 0; i < len; ++i) {
+        if (p_name[i] == '\0' || TOLOWER(p_name[i]) != TOLOWER(p_span[i])) return 0;
+    }
+    return p_name[len] == '\0';
+}
 
-    /* Read first line */
-    int len = ini_readln(in_file, p_buf, MAX_LINE_LENGTH);
-    if (len < 0) return len;
+/* Structural token positions of one line */
+struct ini_tokens {
+    size_t eol;         /* Offset of '\n' or length of buffer */
+    size_t close;       /* First ']' or INI_NO_TOKEN */
+    size_t delim;       /* First '=' or ':' or INI_NO_TOKEN */
+    size_t comment;     /* First ';' or '#' after delim or INI_NO_TOKEN */
+    size_t quote;       /* First '"' after delim or INI_NO_TOKEN */
+    size_t unquote;     /* Second '"' after delim or INI_NO_TOKEN */
+    size_t escape;      /* First '\\' after delim or INI_NO_TOKEN */
+};
 
-    /* Scan & parse line */
-    int i_buf = 0;
-    int i_key = 0;
+typedef void (*ini_scan_fn)(const char* p_buf, size_t len, struct ini_tokens* p_tok);
 
-    /* Skip leading whitespace */
-    while (len - i_buf > 0 && ISSPACE(p_buf[i_buf])) ++i_buf; 
-    if (len - i_buf == 0) return 0;
-    
-    /* Search key name */
-    for (; i_buf < len; ++i_buf, ++i_key) {
-        if (p_key[i_key] == '\0') break; // We found the key
-        if (TOLOWER(p_buf[i_buf]) != TOLOWER(p_key[i_key])) return 0; /* Key not found */
+static const unsigned char ini_structural[256] = {
+    ['\n'] = 1, [']'] = 1, ['='] = 1, [':'] = 1, [';'] = 1, ['#'] = 1, ['"'] = 1, ['\\'] = 1,
+};
+
+static inline int
+ini_scan_token(const char* p_buf,
+               size_t i,
+               struct ini_tokens* p_tok)
+{
+    switch (p_buf[i]) {
+        case '\n': p_tok->eol = i; return 1;
+        case ']': if (p_tok->close == INI_NO_TOKEN) p_tok->close = i; break;
+        case '=': case ':': if (p_tok->delim == INI_NO_TOKEN) p_tok->delim = i; break;
+        case ';': case '#':
+            if (p_tok->delim != INI_NO_TOKEN && p_tok->comment == INI_NO_TOKEN) p_tok->comment = i;
+            break;
+        case '"':
+            if (p_tok->delim == INI_NO_TOKEN || p_tok->unquote != INI_NO_TOKEN) break;
+            if (p_tok->quote == INI_NO_TOKEN) p_tok->quote = i;
+            else p_tok->unquote = i;
+            break;
+        case '\\':
+            if (p_tok->delim != INI_NO_TOKEN && p_tok->escape == INI_NO_TOKEN) p_tok->escape = i;
+            break;
+        default: break;
     }
-    /* Search '=' or ':' */
-    for (; i_buf < len; ++i_buf) {
-        if (p_buf[i_buf] == '=' || p_buf[i_buf] == ':') return i_buf+1; /* Return the index after the '=' character */
-        if (!ISSPACE(p_buf[i_buf])) return 0; /* Bad syntax? Key not found */
+    return 0;
+}
+
+static inline void
+ini_scan_tail(const char* p_buf,
+              size_t i,
+              size_t len,
+              struct ini_tokens* p_tok)
+{
+    for (; i < len; ++i) {
+        if (ini_structural[(unsigned char)p_buf[i]] && ini_scan_token(p_buf, i, p_tok)) return;
     }
-    return 0; /* Key not found */
+    p_tok->eol = len;
 }
 
-LIB_EXPORT int
-ini_get_section(const char* filename,
-                const char* p_section,
-                char* p_key[], size_t size_keys,
-                char* p_value[], size_t size_value,
-                char* buffer[], size_t size_buffer)
+static void
+ini_scan_scalar(const char* p_buf,
+                size_t len,
+                struct ini_tokens* p_tok)
 {
-    int key_idx = 0;
-    int result;
+    p_tok->close = p_tok->delim = p_tok->comment = INI_NO_TOKEN;
+    p_tok->quote = p_tok->unquote = p_tok->escape = INI_NO_TOKEN;
+    ini_scan_tail(p_buf, 0, len, p_tok);
+}
 
-    /* Pointer check */
-    if (!filename || !p_section || !p_key || !p_value || !buffer ) return RET_NULL;
-    p_value[0] = '\0'; /* Empty string for not found */
+#ifdef INI_SIMD_X86
+__attribute__((target("sse2"))) static void
+ini_scan_sse2(const char* p_buf,
+              size_t len,
+              struct ini_tokens* p_tok)
+{
+    const __m128i nl = _mm_set1_epi8('\n'), cb = _mm_set1_epi8(']');
+    const __m128i eq = _mm_set1_epi8('='), co = _mm_set1_epi8(':');
+    const __m128i sc = _mm_set1_epi8(';'), ha = _mm_set1_epi8('#');
+    const __m128i qu = _mm_set1_epi8('"'), bs = _mm_set1_epi8('\\');
+    size_t i = 0;
 
-    /* Open file for reading */
-    FILE* file = fopen(filename, "r");
-    if (!file) return RET_ERRNO; /* File not found or could not be opened */
+    p_tok->close = p_tok->delim = p_tok->comment = INI_NO_TOKEN;
+    p_tok->quote = p_tok->unquote = p_tok->escape = INI_NO_TOKEN;
 
-    /* Read and scan for Section */
-    do { result = ini_scan_for_section(file, buffer, p_section); } while (result == 0);
-    if (result < 0) { fclose(file); return result; }
+    /* Classify 16 bytes at a time, visit only structural bytes */
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p_buf + i));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, cb)),
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, eq), _mm_cmpeq_epi8(v, co)),
+                                 _mm_or_si128(_mm_cmpeq_epi8(v, sc), _mm_cmpeq_epi8(v, ha))));
+        m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, qu), _mm_cmpeq_epi8(v, bs)));
+        for (unsigned mask = (unsigned)_mm_movemask_epi8(m); mask; mask &= mask - 1) {
+            if (ini_scan_token(p_buf, i + __builtin_ctz(mask), p_tok)) return;
+        }
+    }
+    ini_scan_tail(p_buf, i, len, p_tok);
+}
+
+__attribute__((target("avx2"))) static void
+ini_scan_avx2(const char* p_buf,
+              size_t len,
+              struct ini_tokens* p_tok)
+{
+    const __m256i nl = _mm256_set1_epi8('\n'), cb = _mm256_set1_epi8(']');
+    const __m256i eq = _mm256_set1_epi8('='), co = _mm256_set1_epi8(':');
+    const __m256i sc = _mm256_set1_epi8(';'), ha = _mm256_set1_epi8('#');
+    const __m256i qu = _mm256_set1_epi8('"'), bs = _mm256_set1_epi8('\\');
+    size_t i = 0;
 
-        /* Read first line */
-    int len = ini_readln(in_file, p_buf, MAX_LINE_LENGTH);
-    if (len < 0) return len;
+    p_tok->close = p_tok->delim = p_tok->comment = INI_NO_TOKEN;
+    p_tok->quote = p_tok->unquote = p_tok->escape = INI_NO_TOKEN;
 
+    /* Classify 32 bytes at a time, visit only structural bytes */
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p_buf + i));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, nl), _mm256_cmpeq_epi8(v, cb)),
+                    _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, eq), _mm256_cmpeq_epi8(v, co)),
+                                    _mm256_or_si256(_mm256_cmpeq_epi8(v, sc), _mm256_cmpeq_epi8(v, ha))));
+        m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, qu), _mm256_cmpeq_epi8(v, bs)));
+        for (unsigned mask = (unsigned)_mm256_movemask_epi8(m); mask; mask &= mask - 1) {
+            if (ini_scan_token(p_buf, i + __builtin_ctz(mask), p_tok)) return;
+        }
+    }
+    ini_scan_tail(p_buf, i, len, p_tok);
 }
-LIB_EXPORT int
-ini_read_key(const char* filename,
-             const char* p_section,
-             const char* p_key,
-             char* p_value,
-             size_t value_size) 
+#endif
+
+static ini_scan_fn
+ini_scan_select(void)
 {
-    char buffer[MAX_LINE_LENGTH];
-    int result = 0;
-    
-    /* Input parameter check */
-    if (!filename || !p_section || !p_key || !p_value || value_size == 0) return -1; /* Invalid parameters */
-    p_value[0] = '\0'; /* Empty string for not found */
+#ifdef INI_SIMD_X86
+    if (__builtin_cpu_supports("avx2")) return ini_scan_avx2;
+    if (__builtin_cpu_supports("sse2")) return ini_scan_sse2;
+#endif
+    return ini_scan_scalar;
+}
 
-    /* Open file for reading */
-    FILE* file = fopen(filename, "r");
-    if (!file) return RET_ERRNO; /* File not found or could not be opened */
+static void*
+ini_arena_alloc(struct ini_arena* p_arena,
+                size_t size,
+                size_t align)
+{
+    /* Bump the head block, start a bigger one when it is full */
+    struct ini_block* p_block = p_arena->p_head;
+    size_t off = p_block ? (p_block->used + align - 1) & ~(align - 1) : 0;
+    if (!p_block || off + size > p_block->size) {
+        size_t block_size = p_block ? p_block->size * 2 : INI_ARENA_BLOCK;
+        if (block_size > INI_ARENA_MAX) block_size = INI_ARENA_MAX;
+        if (block_size < size) block_size = size;
+        p_block = malloc(sizeof(*p_block) + block_size);
+        if (!p_block) return NULL;
+        p_block->p_next = p_arena->p_head;
+        p_block->size = block_size;
+        p_block->used = 0;
+        p_arena->p_head = p_block;
+        p_arena->reserved += block_size;
+        off = 0;
+    }
+    p_arena->used += off - p_block->used + size;
+    p_block->used = off + size;
+    return p_block->data + off;
+}
 
-    /* Read and scan for Section */
-    do { result = ini_scan_for_section(file, buffer, p_section); } while (result == 0);
-    if (result < 0) { fclose(file); return result; }
-    
-    /* Read and Scan for Key */
-    do { result = ini_scan_for_key(file, buffer, p_key); } while (result == 0);
-    if (result < 0) { fclose(file); return result; }
-    fclose(file);
+static void
+ini_arena_shrink(struct ini_arena* p_arena,
+                 size_t unused)
+{
+    /* Give back the tail of the last allocation */
+    p_arena->p_head->used -= unused;
+    p_arena->used -= unused;
+}
 
-    /* Advance past whitespace to value start */
-    size_t i = result;
-    while (ISSPACE(buffer[i])) { ++i; } 
-                
-    /* Parse rest as value and return length of value */
-    return ini_parse_value(buffer + i, p_value, value_size);
+static void
+ini_arena_free(struct ini_arena* p_arena)
+{
+    while (p_arena->p_head) {
+        struct ini_block* p_next = p_arena->p_head->p_next;
+        free(p_arena->p_head);
+        p_arena->p_head = p_next;
+    }
+    p_arena->reserved = p_arena->used = 0;
 }
 
-LIB_EXPORT int
-ini_write_key(const char* filename, 
-              const char* p_section, 
-              const char* p_key, 
-              const char* p_value, 
-              const char* p_comment)
+static void
+ini_arena_join(struct ini_arena* p_arena,
+               struct ini_arena* p_other)
 {
-    char buffer[MAX_LINE_LENGTH], temp_name[INI_TMP_NAME_LEN];
-    int result = 0, temp_created = 0;
-    FILE* file_out = NULL;
-    FILE* file_in = NULL;
+    /* Blocks of the other arena go behind the head, allocation continues in the head */
+    if (!p_other->p_head) return;
+    struct ini_block* p_tail = p_other->p_head;
+    while (p_tail->p_next) p_tail = p_tail->p_next;
+    if (p_arena->p_head) {
+        p_tail->p_next = p_arena->p_head->p_next;
+        p_arena->p_head->p_next = p_other->p_head;
+    }
+    else p_arena->p_head = p_other->p_head;
+    p_arena->reserved += p_other->reserved;
+    p_arena->used += p_other->used;
+    p_other->p_head = NULL;
+    p_other->reserved = p_other->used = 0;
+}
 
-    /* Check input pointers */
-    if (!filename || !p_section || !p_key || !p_value) return RET_NULL;
+static inline const char*
+ini_name_lower(const struct ini_name* p_name)
+{
+    return p_name->text + p_name->len + 1;
+}
 
-    /* Generate Temporary Filename */
-    result = ini_temp_file(temp_name, sizeof(temp_name));
-    if (result < 0) return result;
+static inline int
+ini_name_is(const struct ini_name* p_name,
+            const char* p_str,
+            size_t len)
+{
+    /* Stored lowercased, only the other side is folded */
+    if (p_name->len != len) return 0;
+    const char* p_lower = ini_name_lower(p_name);
+    for (size_t i = 0; i < len; ++i) {
+        if (TOLOWER(p_str[i]) != p_lower[i]) return 0;
+    }
+    return 1;
+}
 
-    /* Open temporary file for writing */
-    file_out = fopen(temp_name, "w");
-    if (!file_out) return RET_ERRNO;
-    temp_created = 1;
-    
-    /* Open actual ini file for reading */
-    file_in = fopen(filename, "r");
-    if (!file_in) { /* INI-file read error */
-        if (errno != ENOENT) { result = RET_ERRNO; goto cleanup; }
-        
-        /* Create new file with section/key */
-        if ((result = ini_write_header(file_out)) < 0) goto cleanup;
-        if ((result = ini_writef(file_out, "[%s]", p_section)) < 0) goto cleanup;
-        if ((result = ini_write_value(file_out, p_key, p_value, p_comment)) < 0) goto cleanup;
-    } 
-    
-    else { /* INI file found, scan and update */
- 
-        /* Read and scan for Section */
-        while ((result = ini_scan_for_section(file_in, buffer, p_section)) == 0)
-        {
-            /* Copy line to output */
-            if ((result = ini_writeln(file_out, buffer)) < 0) goto cleanup;
-        }
-
-        /* Check scan section result */
-        if (result == RET_EOF) { /* No section found */
-            fclose(file_in); file_in = NULL;
-            
-            /* Create new section/key */
-            result = ini_writef(file_out, "\n[%s]", p_section);
-            if (result >= 0) result = ini_write_value(file_out, p_key, p_value, p_comment);
-            if (result < 0) goto cleanup; 
-        }
-
-        else if (result < 0) goto cleanup; /* Scan section error */
-
-        else { /* Section found */
-            /* Get the section line copied too */
-            if ((result = ini_writeln(file_out, buffer)) < 0) goto cleanup;
-
-            /* Read and Scan for Key */
-            while ((result = ini_scan_for_key(file_in, buffer, p_key)) == 0) { // TODO Doesn't stop for [section]
-                /* Copy line to output */
-                if ((result = ini_writeln(file_out, buffer)) < 0) goto cleanup;  
+static const struct ini_name*
+ini_doc_intern(struct ini_doc* p_doc,
+               const char* p_str,
+               size_t len,
+               uint64_t hash,
+               struct ini_name* p_own)
+{
+    /* Grow the table at load factor 0.5 */
+    if (p_doc->name_count * 2 >= p_doc->name_slots) {
+        size_t slots = p_doc->name_slots ? p_doc->name_slots * 2 : 64;
+        struct ini_name** p_names = calloc(slots, sizeof(*p_names));
+        if (!p_names) return NULL;
+        for (size_t i = 0; i < p_doc->name_slots; ++i) {
+            for (struct ini_name* p_name = p_doc->p_names[i], *p_next; p_name; p_name = p_next) {
+                p_next = p_name->p_next;
+                p_name->p_next = p_names[p_name->hash & (slots - 1)];
+                p_names[p_name->hash & (slots - 1)] = p_name;
             }
+        }
+        free(p_doc->p_names);
+        p_doc->p_names = p_names;
+        p_doc->name_slots = slots;
+    }
 
-            /* Check scan results */
-            if (result == RET_EOF) { /* No key found */
-                fclose(file_in); file_in = NULL;
-                
-                /* Create new key */
-                result = ini_write_value(file_out, p_key, p_value, p_comment);
-                if (result < 0) goto cleanup;
-            }
+    /* Same spelling shares one copy, other spellings get their own */
+    struct ini_name** p_slot = &p_doc->p_names[hash & (p_doc->name_slots - 1)];
+    for (struct ini_name* p_name = *p_slot; p_name; p_name = p_name->p_next) {
+        if (p_name->hash == hash && p_name->len == len && memcmp(p_name->text, p_str, len) == 0) return p_name;
+    }
+    if (p_own) { /* Name of a merged chunk, already in an arena that joins this one */
+        p_own->p_next = *p_slot;
+        *p_slot = p_own;
+        p_doc->name_count++;
+        return p_own;
+    }
+    struct ini_name* p_name = ini_arena_alloc(&p_doc->arena, sizeof(*p_name) + 2 * (len + 1), _Alignof(struct ini_name));
+    if (!p_name) return NULL;
+    p_name->hash = hash;
+    p_name->len = len;
+    memcpy(p_name->text, p_str, len);
+    p_name->text[len] = '\0';
+    char* p_lower = p_name->text + len + 1;
+    for (size_t i = 0; i < len; ++i) p_lower[i] = (char)TOLOWER(p_str[i]);
+    p_lower[len] = '\0';
+    p_name->p_next = *p_slot;
+    *p_slot = p_name;
+    p_doc->name_count++;
+    return p_name;
+}
+
+static int
+ini_doc_add_section(struct ini_doc* p_doc,
+                    const char* p_name,
+                    size_t name_len)
+{
+    /* Grow section table */
+    if (p_doc->section_count == p_doc->section_size) {
+        size_t size = p_doc->section_size ? p_doc->section_size * 2 : 16;
+        struct ini_section* p_sections = realloc(p_doc->p_sections, size * sizeof(*p_sections));
+        if (!p_sections) return RET_ERRNO;
+        p_doc->p_sections = p_sections;
+        p_doc->section_size = size;
+    }
 
-            else if (result < 0) goto cleanup;  /* Scan key error */ 
+    uint64_t hash = ini_hash_str(INI_HASH_OFFSET, p_name, name_len);
+    const struct ini_name* p_interned = ini_doc_intern(p_doc, p_name, name_len, hash, NULL);
+    if (!p_interned) return RET_ERRNO;
 
-            else { /* Key found */
-                if ((result = ini_write_value(file_out, p_key, p_value, NULL)) < 0) goto cleanup;
-                
-                /* Copy rest of file */
-                while ((result = ini_readln(file_in, buffer, MAX_LINE_LENGTH)) >= 0) {
-                    /* Copy line to output */
-                    result = ini_writeln(file_out, buffer); 
-                    if (result < 0) goto cleanup;
-                }
-                /* Check copy results */
-                if (result != RET_EOF) goto cleanup;
-            }        
-        }
+    struct ini_section* p_section = &p_doc->p_sections[p_doc->section_count++];
+    p_section->hash = hash;
+    p_section->next = INI_NO_ENTRY;
+    p_section->p_name = p_interned;
+    p_section->first = p_doc->entry_count;
+    p_section->count = 0;
+    return RET_OK;
+}
+
+static int
+ini_doc_add(struct ini_doc* p_doc,
+            const char* p_key,
+            int key_len,
+            const char* p_value,
+            int value_len,
+            int quoted)
+{
+    /* Grow entry table */
+    if (p_doc->entry_count == p_doc->entry_size) {
+        size_t size = p_doc->entry_size ? p_doc->entry_size * 2 : 64;
+        struct ini_entry* p_entries = realloc(p_doc->p_entries, size * sizeof(*p_entries));
+        if (!p_entries) return RET_ERRNO;
+        p_doc->p_entries = p_entries;
+        p_doc->entry_size = size;
     }
-    if (file_in) fclose(file_in);
-    if (file_out) fclose(file_out);
 
-    return ini_replace_file(temp_name, filename);
+    /* Key names repeat across sections and are interned, values are not */
+    const struct ini_name* p_name = ini_doc_intern(p_doc, p_key, key_len, ini_hash_str(INI_HASH_OFFSET, p_key, key_len), NULL);
+    if (!p_name) return RET_ERRNO;
+    size_t value_size = value_len + 1; /* Parsed value is never longer than source */
+    char* p_mem = ini_arena_alloc(&p_doc->arena, value_size, 1);
+    if (!p_mem) return RET_ERRNO;
 
-cleanup:
-    if (file_in) fclose(file_in);
-    if (file_out) fclose(file_out);
-    if (temp_created) remove(temp_name);
-    return result;
+    /* Entries belong to the last section header */
+    struct ini_section* p_section = &p_doc->p_sections[p_doc->section_count - 1];
+    struct ini_entry* p_entry = &p_doc->p_entries[p_doc->entry_count++];
+    p_section->count++;
+    p_entry->hash = ini_hash_key(p_section->hash, p_key, key_len);
+    p_entry->next = INI_NO_ENTRY;
+    p_entry->p_section = p_section->p_name;
+    p_entry->p_key = p_name;
+    p_entry->p_value = p_mem;
+    if (quoted) {
+        p_entry->value_len = ini_parse_value(p_value, value_len, p_mem, value_size);
+        ini_arena_shrink(&p_doc->arena, value_len - p_entry->value_len);
+    }
+    else { /* Already trimmed by the tokenizer */
+        memcpy(p_mem, p_value, value_len);
+        p_mem[value_len] = '\0';
+        p_entry->value_len = value_len;
+    }
+    return RET_OK;
+}
+
+static size_t*
+ini_doc_buckets(size_t n,
+                size_t* p_count)
+{
+    /* Keep load factor below 0.5 */
+    size_t count = 16;
+    while (count < n * 2) count *= 2;
+
+    size_t* p_buckets = malloc(count * sizeof(*p_buckets));
+    if (!p_buckets) return NULL;
+    for (size_t i = 0; i < count; ++i) p_buckets[i] = INI_NO_ENTRY;
+    *p_count = count;
+    return p_buckets;
 }
 
+static int
+ini_doc_index(struct ini_doc* p_doc)
+{
+    size_t count;
+
+    /* Insert backwards so chains are in file order, first key wins */
+    p_doc->p_buckets = ini_doc_buckets(p_doc->entry_count, &count);
+    if (!p_doc->p_buckets) return RET_ERRNO;
+    p_doc->bucket_count = count;
+    for (size_t i = p_doc->entry_count; i-- > 0;) {
+        size_t* p_head = &p_doc->p_buckets[p_doc->p_entries[i].hash & (count - 1)];
+        p_doc->p_entries[i].next = *p_head;
+        *p_head = i;
+    }
+
+    /* Same for sections, duplicate sections stay chained in file order */
+    p_doc->p_section_buckets = ini_doc_buckets(p_doc->section_count, &count);
+    if (!p_doc->p_section_buckets) return RET_ERRNO;
+    p_doc->section_bucket_count = count;
+    for (size_t i = p_doc->section_count; i-- > 0;) {
+        size_t* p_head = &p_doc->p_section_buckets[p_doc->p_sections[i].hash & (count - 1)];
+        p_doc->p_sections[i].next = *p_head;
+        *p_head = i;
+    }
+    return RET_OK;
+}
+
+static size_t
+ini_doc_mem_size(const struct ini_doc* p_doc)
+{
+    if (p_doc->p_image) return sizeof(*p_doc) + p_doc->p_image->image_size + p_doc->p_image->entry_count * sizeof(*p_doc->p_conv);
+    return sizeof(*p_doc) + p_doc->arena.reserved
+         + p_doc->entry_count * sizeof(*p_doc->p_conv)
+         + p_doc->entry_size * sizeof(*p_doc->p_entries)
+         + p_doc->section_size * sizeof(*p_doc->p_sections)
+         + (p_doc->bucket_count + p_doc->section_bucket_count) * sizeof(size_t);
+}
+
+static uint64_t
+ini_image_mix(uint64_t x)
+{
+    /* splitmix64 finalizer, spreads the FNV bits over the table index */
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static uint32_t
+ini_image_slot(uint64_t hash,
+               uint32_t disp,
+               uint32_t slot_count)
+{
+    return (uint32_t)(ini_image_mix(hash ^ ((uint64_t)disp * 0x9E3779B97F4A7C15ULL)) & (slot_count - 1));
+}
+
+static const char*
+ini_image_str(const struct ini_image* p_image,
+              uint32_t off,
+              uint32_t len)
+{
+    /* Bounds checked, a damaged image finds nothing instead of crashing */
+    if ((uint64_t)off + len >= p_image->strings_size) return NULL;
+    const char* p_str = (const char*)p_image + p_image->strings_off + off;
+    return p_str[len] == '\0' ? p_str : NULL;
+}
+
+static size_t
+ini_image_find(const struct ini_image* p_image,
+               uint64_t hash,
+               const char* p_section,
+               const char* p_key)
+{
+    const char* p_base = (const char*)p_image;
+    const uint32_t* p_disp = (const uint32_t*)(p_base + p_image->disp_off);
+    const uint32_t* p_slots = (const uint32_t*)(p_base + p_image->slots_off);
+
+    /* One displacement and one slot, then verify the names */
+    uint32_t disp = p_disp[ini_image_mix(hash) & (p_image->disp_count - 1)];
+    uint32_t i = p_slots[ini_image_slot(hash, disp, p_image->slot_count)];
+    if (i >= p_image->entry_count) return INI_NO_ENTRY;
+
+    const struct ini_image_entry* p_entry = (const struct ini_image_entry*)(p_base + p_image->entries_off) + i;
+    if (p_entry->hash != hash || p_entry->section >= p_image->section_count) return INI_NO_ENTRY;
+    const struct ini_image_section* p_sec = (const struct ini_image_section*)(p_base + p_image->sections_off) + p_entry->section;
+    const char* p_name = ini_image_str(p_image, p_sec->name_off, p_sec->name_len);
+    const char* p_name_key = ini_image_str(p_image, p_entry->key_off, p_entry->key_len);
+    if (!p_name || !p_name_key || !ini_name_equal(p_name, p_section) || !ini_name_equal(p_name_key, p_key)) return INI_NO_ENTRY;
+    return i;
+}
+
+static size_t
+ini_doc_find(const struct ini_doc* p_doc,
+             const char* p_section,
+             const char* p_key)
+{
+    size_t section_len = strlen(p_section), key_len = strlen(p_key);
+    uint64_t hash = ini_hash(p_section, section_len, p_key, key_len);
+    if (p_doc->p_image) return ini_image_find(p_doc->p_image, hash, p_section, p_key);
+    size_t i = p_doc->p_buckets[hash & (p_doc->bucket_count - 1)];
+
+    for (; i != INI_NO_ENTRY; i = p_doc->p_entries[i].next) {
+        const struct ini_entry* p_entry = &p_doc->p_entries[i];
+        if (p_entry->hash == hash
+            && ini_name_is(p_entry->p_section, p_section, section_len)
+            && ini_name_is(p_entry->p_key, p_key, key_len)) return i;
+    }
+    return INI_NO_ENTRY;
+}
+
+static size_t
+ini_doc_find_hash(const struct ini_doc* p_doc,
+                  uint64_t hash)
+{
+    /* Names are not compared, the first entry with this hash wins */
+    if (p_doc->p_image) {
+        const struct ini_image* p_image = p_doc->p_image;
+        const uint32_t* p_disp = (const uint32_t*)((const char*)p_image + p_image->disp_off);
+        const uint32_t* p_slots = (const uint32_t*)((const char*)p_image + p_image->slots_off);
+        uint32_t i = p_slots[ini_image_slot(hash, p_disp[ini_image_mix(hash) & (p_image->disp_count - 1)], p_image->slot_count)];
+        if (i >= p_image->entry_count) return INI_NO_ENTRY;
+        const struct ini_image_entry* p_entry = (const struct ini_image_entry*)((const char*)p_image + p_image->entries_off) + i;
+        return p_entry->hash == hash ? i : INI_NO_ENTRY;
+    }
+    size_t i = p_doc->p_buckets[hash & (p_doc->bucket_count - 1)];
+    while (i != INI_NO_ENTRY && p_doc->p_entries[i].hash != hash) i = p_doc->p_entries[i].next;
+    return i;
+}
+
+static const char*
+ini_doc_key(const struct ini_doc* p_doc,
+            size_t i,
+            size_t* p_len)
+{
+    if (!p_doc->p_image) {
+        *p_len = p_doc->p_entries[i].p_key->len;
+        return p_doc->p_entries[i].p_key->text;
+    }
+    const struct ini_image_entry* p_entry = (const struct ini_image_entry*)((const char*)p_doc->p_image + p_doc->p_image->entries_off) + i;
+    *p_len = p_entry->key_len;
+    const char* p_key = ini_image_str(p_doc->p_image, p_entry->key_off, p_entry->key_len);
+    if (!p_key) *p_len = 0;
+    return p_key ? p_key : "";
+}
+
+static const char*
+ini_doc_value(const struct ini_doc* p_doc,
+              size_t i,
+              size_t* p_len)
+{
+    if (!p_doc->p_image) {
+        *p_len = p_doc->p_entries[i].value_len;
+        return p_doc->p_entries[i].p_value;
+    }
+    const struct ini_image_entry* p_entry = (const struct ini_image_entry*)((const char*)p_doc->p_image + p_doc->p_image->entries_off) + i;
+    *p_len = p_entry->value_len;
+    const char* p_value = ini_image_str(p_doc->p_image, p_entry->value_off, p_entry->value_len);
+    if (!p_value) *p_len = 0;
+    return p_value ? p_value : "";
+}
+
+LIB_EXPORT void
+ini_close(ini_doc_t* p_doc)
+{
+    if (!p_doc) return;
+#if !defined(_WIN32) && !defined(_WIN64)
+    if (p_doc->p_image) munmap((void*)p_doc->p_image, p_doc->p_image->image_size);
+#endif
+    free(p_doc->p_conv);
+    ini_arena_free(&p_doc->arena);
+    free(p_doc->p_names);
+    free(p_doc->p_entries);
+    free(p_doc->p_buckets);
+    free(p_doc->p_sections);
+    free(p_doc->p_section_buckets);
+    free(p_doc);
+}
+
+/* Spans of one classified line, views into the line */
+struct ini_parts {
+    const char* p_name;     /* Section, key or comment text */
+    size_t name_len;
+    const char* p_value;    /* Value, quoted ones from the opening quote */
+    size_t value_len;
+};
+
+static inline int
+ini_split_line(const char* p_line,
+               size_t len,
+               const struct ini_tokens* p_tok,
+               struct ini_parts* p_parts)
+{
+    size_t i_start = 0, i_end;
+
+    /* Empty lines and comments, comment text trimmed */
+    while (i_start < len && ISSPACE(p_line[i_start])) ++i_start;
+    if (i_start == len) return INI_KIND_BLANK;
+    if (ISCOMMENT(p_line[i_start])) {
+        for (++i_start; i_start < len && ISSPACE(p_line[i_start]); ++i_start);
+        for (i_end = len; i_end > i_start && ISSPACE(p_line[i_end - 1]); --i_end);
+        p_parts->p_name = p_line + i_start;
+        p_parts->name_len = i_end - i_start;
+        return INI_KIND_COMMENT;
+    }
+
+    /* Section header, trim name */
+    if (p_line[i_start] == '[' && p_tok->close < len) {
+        for (++i_start; ISSPACE(p_line[i_start]); ++i_start);
+        for (i_end = p_tok->close; i_end > i_start && ISSPACE(p_line[i_end - 1]); --i_end);
+        p_parts->p_name = p_line + i_start;
+        p_parts->name_len = i_end - i_start;
+        return INI_KIND_SECTION;
+    }
+
+    /* Key ends at '=' or ':' */
+    if (p_tok->delim >= len) return INI_KIND_BAD;
+    for (i_end = p_tok->delim; i_end > i_start && ISSPACE(p_line[i_end - 1]); --i_end);
+    if (i_end == i_start) return INI_KIND_BAD; /* Empty key name */
+    p_parts->p_name = p_line + i_start;
+    p_parts->name_len = i_end - i_start;
+
+    /* Value starts after whitespace, quoted values are decoded by the caller */
+    for (i_start = p_tok->delim + 1; i_start < len && ISSPACE(p_line[i_start]); ++i_start);
+    p_parts->p_value = p_line + i_start;
+    if (i_start < len && p_line[i_start] == '"') {
+        /* Without escapes the text between the quotes is the value, no decoding */
+        if (p_tok->unquote < len && p_tok->escape > p_tok->unquote) {
+            p_parts->p_value = p_line + i_start + 1;
+            p_parts->value_len = p_tok->unquote - i_start - 1;
+            return INI_KIND_KEY;
+        }
+        p_parts->value_len = len - i_start;
+        return INI_KIND_QUOTED;
+    }
+
+    /* Unquoted value ends at comment or EOL, trailing whitespace removed */
+    i_end = p_tok->comment < len ? p_tok->comment : len;
+    while (i_end > i_start && ISSPACE(p_line[i_end - 1])) --i_end;
+    p_parts->value_len = i_end - i_start;
+    return INI_KIND_KEY;
+}
+
+static int
+ini_classify_line(ini_scan_fn scan,
+                  const char* p_line,
+                  size_t len,
+                  struct ini_parts* p_parts)
+{
+    /* Writers find lines with the same tokenizer and classifier as the readers */
+    struct ini_tokens tok;
+    scan(p_line, len, &tok);
+    return ini_split_line(p_line, len, &tok, p_parts);
+}
+
+static int
+ini_doc_parse_line(struct ini_doc* p_doc,
+                   const char* p_line,
+                   size_t len,
+                   const struct ini_tokens* p_tok)
+{
+    struct ini_parts parts;
+
+    /* Comments and malformed lines are ignored */
+    int kind = ini_split_line(p_line, len, p_tok, &parts);
+    if (kind == INI_KIND_SECTION) return ini_doc_add_section(p_doc, parts.p_name, parts.name_len);
+    if (kind != INI_KIND_KEY && kind != INI_KIND_QUOTED) return RET_OK;
+    if (len > INT32_MAX) return RET_BUF;
+    return ini_doc_add(p_doc, parts.p_name, (int)parts.name_len,
+                       parts.p_value, (int)parts.value_len, kind == INI_KIND_QUOTED);
+}
+
+static int
+ini_doc_parse_file(struct ini_doc* p_doc,
+                   FILE* file)
+{
+    struct ini_line line;
+    int len, result = RET_OK;
+    ini_scan_fn scan = ini_scan_select();
+    struct ini_tokens tok;
+
+    ini_line_init(&line);
+
+    /* Parse line by line */
+    while ((len = ini_readln(file, &line)) >= 0) {
+        INI_STAT_ADD(lines_scanned, 1);
+        INI_STAT_ADD(bytes_read, len + 1);
+        scan(line.p_buf, len, &tok);
+        result = ini_doc_parse_line(p_doc, line.p_buf, len, &tok);
+        if (result < 0) break;
+    }
+    if (result >= 0 && len != RET_EOF) result = len;
+    ini_line_free(&line);
+    return result;
+}
+
+static int
+ini_doc_parse_mem(struct ini_doc* p_doc,
+                  const char* p_mem,
+                  size_t size)
+{
+    int result = RET_OK;
+    const char* p_end = p_mem + size;
+    ini_scan_fn scan = ini_scan_select();
+    struct ini_tokens tok;
+    size_t lines = 0;
+
+    /* Tokenize lines directly in memory */
+    INI_STAT_ADD(bytes_read, size);
+    for (; p_mem < p_end; ++lines) {
+        scan(p_mem, p_end - p_mem, &tok);
+        size_t len = tok.eol;
+        if (len > 0 && p_mem[len - 1] == '\r') --len;
+
+        result = ini_doc_parse_line(p_doc, p_mem, len, &tok);
+        if (result < 0) break;
+        if (tok.eol == (size_t)(p_end - p_mem)) { ++lines; break; } /* No newline at EOF */
+        p_mem += tok.eol + 1;
+    }
+    INI_STAT_ADD(lines_scanned, lines);
+    (void)lines;
+    return result;
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+static void
+ini_stamp_set(struct ini_stamp* p_stamp,
+              const struct stat* p_st)
+{
+    p_stamp->dev = (uint64_t)p_st->st_dev;
+    p_stamp->ino = (uint64_t)p_st->st_ino;
+    p_stamp->size = (int64_t)p_st->st_size;
+    p_stamp->mtime_sec = (int64_t)p_st->st_mtim.tv_sec;
+    p_stamp->mtime_nsec = p_st->st_mtim.tv_nsec;
+}
+
+static int
+ini_stamp_equal(const struct ini_stamp* p_a,
+                const struct ini_stamp* p_b)
+{
+    /* Field by field, the struct may have tail padding */
+    return p_a->dev == p_b->dev && p_a->ino == p_b->ino && p_a->size == p_b->size
+        && p_a->mtime_sec == p_b->mtime_sec && p_a->mtime_nsec == p_b->mtime_nsec;
+}
+#endif
+
+#if !defined(_WIN32) && !defined(_WIN64)
+static int
+ini_image_fits(uint32_t off,
+               uint64_t count,
+               size_t item_size,
+               size_t size)
+{
+    return off % 8 == 0 && off >= sizeof(struct ini_image) && off + count * item_size <= size;
+}
+
+static int
+ini_image_valid(const struct ini_image* p_image,
+                size_t size,
+                const struct ini_stamp* p_stamp)
+{
+    /* Built by this version on a host with the same byte order */
+    if (memcmp(p_image->magic, INI_IMAGE_MAGIC, sizeof(INI_IMAGE_MAGIC)) != 0
+        || p_image->version != INI_IMAGE_VERSION || p_image->byte_order != INI_IMAGE_ORDER
+        || p_image->image_size != size) return 0;
+
+    /* Stale when the source was replaced or modified since compiling */
+    if (p_image->src_dev != p_stamp->dev || p_image->src_ino != p_stamp->ino || p_image->src_size != p_stamp->size
+        || p_image->src_mtime_sec != p_stamp->mtime_sec || p_image->src_mtime_nsec != p_stamp->mtime_nsec) return 0;
+
+    /* Every table must lie inside the mapping */
+    if (p_image->section_count == 0 || p_image->slot_count == 0 || p_image->disp_count == 0
+        || (p_image->slot_count & (p_image->slot_count - 1)) != 0
+        || (p_image->disp_count & (p_image->disp_count - 1)) != 0) return 0;
+    return ini_image_fits(p_image->entries_off, p_image->entry_count, sizeof(struct ini_image_entry), size)
+        && ini_image_fits(p_image->sections_off, p_image->section_count, sizeof(struct ini_image_section), size)
+        && ini_image_fits(p_image->disp_off, p_image->disp_count, sizeof(uint32_t), size)
+        && ini_image_fits(p_image->slots_off, p_image->slot_count, sizeof(uint32_t), size)
+        && ini_image_fits(p_image->strings_off, p_image->strings_size, 1, size);
+}
+
+static int
+ini_image_load(struct ini_doc* p_doc,
+               const char* filename)
+{
+    char image_name[INI_TMP_NAME_LEN];
+    struct stat st;
+    struct ini_stamp stamp;
+
+    /* The image lives next to its source, any problem means parsing the text */
+    int len = snprintf(image_name, sizeof(image_name), "%s.bin", filename);
+    if (len < 0 || (size_t)len >= sizeof(image_name)) return 0;
+    if (stat(filename, &st) != 0 || !S_ISREG(st.st_mode)) return 0;
+    ini_stamp_set(&stamp, &st);
+
+    int fd = open(image_name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    INI_STAT_ADD(files_opened, 1);
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(struct ini_image)) { close(fd); return 0; }
+    size_t size = (size_t)st.st_size;
+    const struct ini_image* p_image = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p_image == MAP_FAILED) return 0;
+
+    /* Only the typed value cache is allocated, the tables are used in place */
+    if (!ini_image_valid(p_image, size, &stamp)
+        || !(p_doc->p_conv = calloc(p_image->entry_count + 1, sizeof(*p_doc->p_conv)))) {
+        munmap((void*)p_image, size);
+        return 0;
+    }
+    p_doc->p_image = p_image;
+    p_doc->stamp = stamp;
+    return 1;
+}
+
+/* Perfect hash bucket, placed largest first */
+struct ini_image_bucket {
+    uint32_t id;
+    uint32_t count;
+    uint32_t first;     /* Index into the bucket ordered key list */
+};
+
+static int
+ini_image_bucket_cmp(const void* p_a,
+                     const void* p_b)
+{
+    const struct ini_image_bucket* p_x = p_a;
+    const struct ini_image_bucket* p_y = p_b;
+    if (p_x->count != p_y->count) return p_x->count < p_y->count ? 1 : -1;
+    return p_x->id < p_y->id ? -1 : p_x->id > p_y->id;
+}
+
+static int
+ini_image_hash(const struct ini_doc* p_doc,
+               const uint32_t* p_keys,
+               uint32_t key_count,
+               uint32_t* p_disp,
+               uint32_t disp_count,
+               uint32_t* p_slots,
+               uint32_t slot_count)
+{
+    int result = RET_OK;
+    struct ini_image_bucket* p_buckets = calloc(disp_count, sizeof(*p_buckets));
+    uint32_t* p_order = malloc((key_count + 1) * sizeof(*p_order));
+    uint32_t* p_placed = malloc((key_count + 1) * sizeof(*p_placed));
+    if (!p_buckets || !p_order || !p_placed) { result = RET_ERRNO; goto cleanup; }
+
+    /* Hash and displace: group keys by bucket */
+    for (uint32_t b = 0; b < disp_count; ++b) p_buckets[b].id = b;
+    for (uint32_t k = 0; k < key_count; ++k) p_buckets[ini_image_mix(p_doc->p_entries[p_keys[k]].hash) & (disp_count - 1)].count++;
+    for (uint32_t b = 0, first = 0; b < disp_count; first += p_buckets[b++].count) p_buckets[b].first = first;
+    for (uint32_t k = 0; k < key_count; ++k) {
+        struct ini_image_bucket* p_bucket = &p_buckets[ini_image_mix(p_doc->p_entries[p_keys[k]].hash) & (disp_count - 1)];
+        p_order[p_bucket->first++] = p_keys[k];
+    }
+    for (uint32_t b = 0; b < disp_count; ++b) p_buckets[b].first -= p_buckets[b].count;
+    qsort(p_buckets, disp_count, sizeof(*p_buckets), ini_image_bucket_cmp);
+
+    /* Find a displacement that puts every key of the bucket in a free slot */
+    for (uint32_t i = 0; i < slot_count; ++i) p_slots[i] = INI_IMAGE_NONE;
+    for (uint32_t b = 0; b < disp_count && p_buckets[b].count > 0; ++b) {
+        const struct ini_image_bucket* p_bucket = &p_buckets[b];
+        uint32_t disp = 0, placed = 0;
+        for (; disp < INI_IMAGE_TRIES; ++disp) {
+            for (placed = 0; placed < p_bucket->count; ++placed) {
+                uint32_t entry = p_order[p_bucket->first + placed];
+                uint32_t slot = ini_image_slot(p_doc->p_entries[entry].hash, disp, slot_count);
+                if (p_slots[slot] != INI_IMAGE_NONE) break;
+                p_slots[slot] = entry;
+                p_placed[placed] = slot;
+            }
+            if (placed == p_bucket->count) break;
+            while (placed > 0) p_slots[p_placed[--placed]] = INI_IMAGE_NONE; /* Undo */
+        }
+        if (disp == INI_IMAGE_TRIES) { result = RET_ERR; goto cleanup; } /* Full 64 bit hash collision */
+        p_disp[p_bucket->id] = disp;
+    }
+
+cleanup:
+    free(p_buckets);
+    free(p_order);
+    free(p_placed);
+    return result;
+}
+
+static uint32_t
+ini_image_align(uint64_t off)
+{
+    return (uint32_t)((off + 7) & ~(uint64_t)7);
+}
+
+static int
+ini_image_pad(FILE* file,
+              uint64_t pos,
+              uint32_t off)
+{
+    static const char padding[8] = { 0 };
+    return pos == off || fwrite(padding, (size_t)(off - pos), 1, file) == 1;
+}
+
+static int
+ini_image_write(const struct ini_doc* p_doc,
+                FILE* file)
+{
+    struct ini_image header;
+    uint32_t* p_keys = NULL;
+    uint32_t* p_tables = NULL;
+    int result = RET_OK;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INI_IMAGE_MAGIC, sizeof(INI_IMAGE_MAGIC));
+    header.version = INI_IMAGE_VERSION;
+    header.byte_order = INI_IMAGE_ORDER;
+
+    /* Offsets are 32 bit */
+    uint64_t strings_size = 0;
+    for (size_t s = 0; s < p_doc->section_count; ++s) strings_size += p_doc->p_sections[s].p_name->len + 1;
+    for (size_t i = 0; i < p_doc->entry_count; ++i) strings_size += p_doc->p_entries[i].p_key->len + p_doc->p_entries[i].value_len + 2;
+    if (p_doc->entry_count >= INI_IMAGE_NONE || strings_size > UINT32_MAX / 2) return RET_BUF;
+
+    /* Only the entry a lookup returns is hashed, duplicates stay for enumeration */
+    uint32_t key_count = 0;
+    p_keys = malloc((p_doc->entry_count + 1) * sizeof(*p_keys));
+    if (!p_keys) return RET_ERRNO;
+    for (size_t i = 0; i < p_doc->entry_count; ++i) {
+        const struct ini_entry* p_entry = &p_doc->p_entries[i];
+        if (ini_doc_find(p_doc, p_entry->p_section->text, p_entry->p_key->text) == i) p_keys[key_count++] = (uint32_t)i;
+    }
+
+    /* Load factor 0.4 to 0.8, about four keys per displacement */
+    header.slot_count = 1;
+    while (header.slot_count < key_count + key_count / 4 + 1) header.slot_count *= 2;
+    header.disp_count = 1;
+    while (header.disp_count < key_count / 4) header.disp_count *= 2;
+    p_tables = malloc(((size_t)header.disp_count + header.slot_count) * sizeof(*p_tables));
+    if (!p_tables) { result = RET_ERRNO; goto cleanup; }
+    for (uint32_t i = 0; i < header.disp_count; ++i) p_tables[i] = 0;
+    result = ini_image_hash(p_doc, p_keys, key_count, p_tables, header.disp_count, p_tables + header.disp_count, header.slot_count);
+    if (result < 0) goto cleanup;
+
+    /* Header, entries, sections, displacements, slots, strings */
+    header.src_dev = p_doc->stamp.dev;
+    header.src_ino = p_doc->stamp.ino;
+    header.src_size = p_doc->stamp.size;
+    header.src_mtime_sec = p_doc->stamp.mtime_sec;
+    header.src_mtime_nsec = p_doc->stamp.mtime_nsec;
+    header.entry_count = (uint32_t)p_doc->entry_count;
+    header.section_count = (uint32_t)p_doc->section_count;
+    header.entries_off = ini_image_align(sizeof(header));
+    header.sections_off = ini_image_align(header.entries_off + (uint64_t)header.entry_count * sizeof(struct ini_image_entry));
+    header.disp_off = ini_image_align(header.sections_off + (uint64_t)header.section_count * sizeof(struct ini_image_section));
+    header.slots_off = ini_image_align(header.disp_off + (uint64_t)header.disp_count * sizeof(uint32_t));
+    header.strings_off = ini_image_align(header.slots_off + (uint64_t)header.slot_count * sizeof(uint32_t));
+    header.strings_size = (uint32_t)strings_size;
+    header.image_size = (uint64_t)header.strings_off + header.strings_size;
+    if (header.image_size > UINT32_MAX) { result = RET_BUF; goto cleanup; }
+
+    if (fwrite(&header, sizeof(header), 1, file) != 1) goto write_error;
+    if (!ini_image_pad(file, sizeof(header), header.entries_off)) goto write_error;
+
+    /* Strings are laid out section by section in file order */
+    uint32_t off = 0;
+    for (size_t s = 0; s < p_doc->section_count; ++s) {
+        const struct ini_section* p_sec = &p_doc->p_sections[s];
+        off += (uint32_t)p_sec->p_name->len + 1;
+        for (size_t i = p_sec->first; i < p_sec->first + p_sec->count; ++i) {
+            const struct ini_entry* p_entry = &p_doc->p_entries[i];
+            struct ini_image_entry entry = { p_entry->hash, (uint32_t)s, off, (uint32_t)p_entry->p_key->len, 0, (uint32_t)p_entry->value_len, 0 };
+            entry.value_off = off + entry.key_len + 1;
+            off = entry.value_off + entry.value_len + 1;
+            if (fwrite(&entry, sizeof(entry), 1, file) != 1) goto write_error;
+        }
+    }
+    if (!ini_image_pad(file, header.entries_off + (uint64_t)header.entry_count * sizeof(struct ini_image_entry), header.sections_off)) goto write_error;
+
+    off = 0;
+    for (size_t s = 0; s < p_doc->section_count; ++s) {
+        const struct ini_section* p_sec = &p_doc->p_sections[s];
+        struct ini_image_section section = { p_sec->hash, off, (uint32_t)p_sec->p_name->len, (uint32_t)p_sec->first, (uint32_t)p_sec->count };
+        off += section.name_len + 1;
+        for (size_t i = p_sec->first; i < p_sec->first + p_sec->count; ++i) off += (uint32_t)(p_doc->p_entries[i].p_key->len + p_doc->p_entries[i].value_len + 2);
+        if (fwrite(&section, sizeof(section), 1, file) != 1) goto write_error;
+    }
+    if (!ini_image_pad(file, header.sections_off + (uint64_t)header.section_count * sizeof(struct ini_image_section), header.disp_off)) goto write_error;
+    if (fwrite(p_tables, sizeof(uint32_t), header.disp_count, file) != header.disp_count) goto write_error;
+    if (!ini_image_pad(file, header.disp_off + (uint64_t)header.disp_count * sizeof(uint32_t), header.slots_off)) goto write_error;
+    if (fwrite(p_tables + header.disp_count, sizeof(uint32_t), header.slot_count, file) != header.slot_count) goto write_error;
+    if (!ini_image_pad(file, header.slots_off + (uint64_t)header.slot_count * sizeof(uint32_t), header.strings_off)) goto write_error;
+
+    for (size_t s = 0; s < p_doc->section_count; ++s) {
+        const struct ini_section* p_sec = &p_doc->p_sections[s];
+        if (fwrite(p_sec->p_name->text, p_sec->p_name->len + 1, 1, file) != 1) goto write_error;
+        for (size_t i = p_sec->first; i < p_sec->first + p_sec->count; ++i) {
+            const struct ini_entry* p_entry = &p_doc->p_entries[i];
+            if (fwrite(p_entry->p_key->text, p_entry->p_key->len + 1, 1, file) != 1) goto write_error;
+            if (fwrite(p_entry->p_value, p_entry->value_len + 1, 1, file) != 1) goto write_error;
+        }
+    }
+    goto cleanup;
+
+write_error:
+    result = RET_ERRNO;
+cleanup:
+    free(p_keys);
+    free(p_tables);
+    return result;
+}
+#endif
+
+#if !defined(_WIN32) && !defined(_WIN64)
+/* Parse thread limit, 0 for one per online CPU */
+static atomic_uint ini_parse_max;
+
+/* Part of a mapped file parsed by one thread */
+struct ini_chunk {
+    struct ini_doc* p_doc;  /* Tables of this chunk only */
+    const char* p_mem;
+    size_t size;
+    int result;
+    int started;
+    pthread_t thread;
+};
+
+static void*
+ini_chunk_thread(void* p_arg)
+{
+    struct ini_chunk* p_chunk = p_arg;
+    p_chunk->result = ini_doc_parse_mem(p_chunk->p_doc, p_chunk->p_mem, p_chunk->size);
+    return NULL;
+}
+
+static size_t
+ini_chunk_find(const char* p_mem,
+               size_t size,
+               size_t pos,
+               size_t end,
+               ini_scan_fn scan)
+{
+    struct ini_tokens tok;
+    struct ini_parts parts;
+
+    /* First section header line starting in [pos, end), lines never span headers */
+    if (pos > 0 && p_mem[pos - 1] != '\n') {
+        const char* p_nl = memchr(p_mem + pos, '\n', size - pos);
+        if (!p_nl) return INI_NO_ENTRY;
+        pos = (size_t)(p_nl - p_mem) + 1;
+    }
+    while (pos < end) {
+        size_t i = pos;
+        while (i < size && ISSPACE(p_mem[i])) ++i;
+        if (i < size && p_mem[i] == '[') {
+            scan(p_mem + pos, size - pos, &tok);
+            size_t len = tok.eol;
+            if (len > 0 && p_mem[pos + len - 1] == '\r') --len;
+            if (ini_split_line(p_mem + pos, len, &tok, &parts) == INI_KIND_SECTION) return pos;
+        }
+        const char* p_nl = memchr(p_mem + i, '\n', size - i);
+        if (!p_nl) break;
+        pos = (size_t)(p_nl - p_mem) + 1;
+    }
+    return INI_NO_ENTRY;
+}
+
+static const struct ini_name*
+ini_doc_adopt(struct ini_doc* p_doc,
+              const struct ini_name* p_name)
+{
+    /* The name lives in the chunk arena, it is linked rather than copied */
+    return ini_doc_intern(p_doc, p_name->text, p_name->len, p_name->hash, (struct ini_name*)p_name);
+}
+
+static int
+ini_doc_merge(struct ini_doc* p_doc,
+              struct ini_doc* p_part)
+{
+    /* Append in file order, names and values change owner */
+    size_t section_count = p_doc->section_count + p_part->section_count;
+    size_t entry_count = p_doc->entry_count + p_part->entry_count;
+    if (section_count > p_doc->section_size) {
+        struct ini_section* p_sections = realloc(p_doc->p_sections, section_count * sizeof(*p_sections));
+        if (!p_sections) return RET_ERRNO;
+        p_doc->p_sections = p_sections;
+        p_doc->section_size = section_count;
+    }
+    if (entry_count > p_doc->entry_size) {
+        struct ini_entry* p_entries = realloc(p_doc->p_entries, entry_count * sizeof(*p_entries));
+        if (!p_entries) return RET_ERRNO;
+        p_doc->p_entries = p_entries;
+        p_doc->entry_size = entry_count;
+    }
+    /* Chunk names join the interned names, known spellings are shared like in a serial parse */
+    for (size_t i = 0; i < p_part->section_count; ++i) {
+        struct ini_section* p_section = &p_doc->p_sections[p_doc->section_count + i];
+        *p_section = p_part->p_sections[i];
+        p_section->first += p_doc->entry_count;
+        if (!(p_section->p_name = ini_doc_adopt(p_doc, p_section->p_name))) return RET_ERRNO;
+        for (size_t j = p_section->first; j < p_section->first + p_section->count; ++j) {
+            struct ini_entry* p_entry = &p_doc->p_entries[j];
+            *p_entry = p_part->p_entries[j - p_doc->entry_count];
+            p_entry->p_section = p_section->p_name;
+            if (!(p_entry->p_key = ini_doc_adopt(p_doc, p_entry->p_key))) return RET_ERRNO;
+        }
+    }
+    p_doc->section_count = section_count;
+    p_doc->entry_count = entry_count;
+    ini_arena_join(&p_doc->arena, &p_part->arena);
+    p_part->section_count = p_part->entry_count = p_part->name_count = 0;
+    return RET_OK;
+}
+
+static int
+ini_doc_parse_parallel(struct ini_doc* p_doc,
+                       const char* p_mem,
+                       size_t size)
+{
+    struct ini_chunk chunks[INI_PARSE_THREADS];
+    ini_scan_fn scan = ini_scan_select();
+    int result = RET_OK;
+
+    /* One chunk per thread, no thread gets less than INI_PARSE_CHUNK */
+    size_t threads = atomic_load_explicit(&ini_parse_max, memory_order_relaxed);
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    if (threads > size / INI_PARSE_CHUNK) threads = size / INI_PARSE_CHUNK;
+    if (threads > INI_PARSE_THREADS) threads = INI_PARSE_THREADS;
+    if (threads < 2) return ini_doc_parse_mem(p_doc, p_mem, size);
+
+    /* Cut at section headers near equal shares, a share without one joins the previous */
+    size_t count = 1, starts[INI_PARSE_THREADS + 1];
+    starts[0] = 0;
+    for (size_t k = 1; k < threads; ++k) {
+        size_t pos = size / threads * k;
+        if (pos <= starts[count - 1]) continue;
+        size_t start = ini_chunk_find(p_mem, size, pos, size / threads * (k + 1), scan);
+        if (start != INI_NO_ENTRY) starts[count++] = start;
+    }
+    starts[count] = size;
+    if (count < 2) return ini_doc_parse_mem(p_doc, p_mem, size);
+
+    /* First chunk continues the document on this thread, others start at a header */
+    memset(chunks, 0, sizeof(chunks));
+    for (size_t k = 1; k < count; ++k) {
+        struct ini_chunk* p_chunk = &chunks[k];
+        p_chunk->p_mem = p_mem + starts[k];
+        p_chunk->size = starts[k + 1] - starts[k];
+        if (!(p_chunk->p_doc = calloc(1, sizeof(*p_chunk->p_doc)))) { p_chunk->result = RET_ERRNO; continue; }
+        p_chunk->started = pthread_create(&p_chunk->thread, NULL, ini_chunk_thread, p_chunk) == 0;
+    }
+    result = ini_doc_parse_mem(p_doc, p_mem, starts[1]);
+    for (size_t k = 1; k < count; ++k) {
+        struct ini_chunk* p_chunk = &chunks[k];
+        if (p_chunk->started) pthread_join(p_chunk->thread, NULL);
+        else if (p_chunk->p_doc) ini_chunk_thread(p_chunk); /* No thread, parse here */
+    }
+
+    /* Merge in file order, duplicate sections keep their order */
+    for (size_t k = 1; k < count; ++k) {
+        struct ini_chunk* p_chunk = &chunks[k];
+        if (result >= 0) result = p_chunk->result;
+        if (result >= 0) result = ini_doc_merge(p_doc, p_chunk->p_doc);
+        ini_close(p_chunk->p_doc);
+    }
+    return result;
+}
+#endif
+
+static int
+ini_doc_load(struct ini_doc* p_doc,
+             const char* filename)
+{
+    int result;
+    FILE* file;
+
+#if defined(_WIN32) || defined(_WIN64)
+    /* Open file for reading */
+    file = fopen(filename, "r");
+    if (!file) return RET_ERRNO; /* File not found or could not be opened */
+    INI_STAT_ADD(files_opened, 1);
+#else
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return RET_ERRNO; /* File not found or could not be opened */
+    INI_STAT_ADD(files_opened, 1);
+
+    /* Regular files are mapped, pipes and special files use stdio */
+    struct stat st;
+    if (fstat(fd, &st) != 0) { result = RET_ERRNO; close(fd); return result; }
+    if (S_ISREG(st.st_mode)) {
+        ini_stamp_set(&p_doc->stamp, &st);
+        if (st.st_size == 0) { close(fd); return RET_OK; } /* Empty file */
+        size_t size = (size_t)st.st_size;
+        void* p_map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p_map != MAP_FAILED) {
+            close(fd);
+            madvise(p_map, size, MADV_SEQUENTIAL);
+            result = ini_doc_parse_parallel(p_doc, p_map, size);
+            munmap(p_map, size);
+            return result;
+        }
+    }
+
+    /* Fall back to stdio */
+    file = fdopen(fd, "r");
+    if (!file) { result = RET_ERRNO; close(fd); return result; }
+#endif
+    result = ini_doc_parse_file(p_doc, file);
+    fclose(file);
+    return result;
+}
+
+static int
+ini_doc_finish(struct ini_doc* p_doc,
+               int result,
+               ini_doc_t** pp_doc)
+{
+    /* Index the parsed entries, the document is released on any error */
+    free(p_doc->p_names); /* Names stay, interning is done */
+    p_doc->p_names = NULL;
+    p_doc->name_slots = 0;
+    if (result >= 0) result = ini_doc_index(p_doc);
+    if (result >= 0 && !(p_doc->p_conv = calloc(p_doc->entry_count + 1, sizeof(*p_doc->p_conv)))) result = RET_ERRNO;
+    if (result < 0) { ini_close(p_doc); return result; }
+
+    *pp_doc = p_doc;
+    return RET_OK;
+}
+
+static int
+ini_doc_open(const char* filename,
+             int use_image,
+             ini_doc_t** pp_doc)
+{
+    /* Input parameter check */
+    if (!filename || !pp_doc) return RET_NULL;
+    *pp_doc = NULL;
+
+    struct ini_doc* p_doc = calloc(1, sizeof(*p_doc));
+    if (!p_doc) return RET_ERRNO;
+
+#if !defined(_WIN32) && !defined(_WIN64)
+    /* A fresh compiled image needs no parsing */
+    if (use_image && ini_image_load(p_doc, filename)) { *pp_doc = p_doc; return RET_OK; }
+#else
+    (void)use_image;
+#endif
+
+    /* Parse file and build hash index */
+    int result = ini_doc_add_section(p_doc, "", 0);
+    if (result >= 0) result = ini_doc_load(p_doc, filename);
+    return ini_doc_finish(p_doc, result, pp_doc);
+}
+
+LIB_EXPORT int
+ini_open(const char* filename,
+         ini_doc_t** pp_doc)
+{
+    INI_STAT_START(start);
+    int result = ini_doc_open(filename, 1, pp_doc);
+    INI_STAT_TIME(open, start);
+    return result;
+}
+
+LIB_EXPORT void
+ini_parse_threads(unsigned threads)
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+    atomic_store_explicit(&ini_parse_max, threads, memory_order_relaxed);
+#else
+    (void)threads;
+#endif
+}
+
+LIB_EXPORT int
+ini_open_mem(const char* p_buf,
+             size_t size,
+             ini_doc_t** pp_doc)
+{
+    /* Input parameter check */
+    if (!p_buf || !pp_doc) return RET_NULL;
+    *pp_doc = NULL;
+
+    struct ini_doc* p_doc = calloc(1, sizeof(*p_doc));
+    if (!p_doc) return RET_ERRNO;
+
+    /* Same tokenizer as a mapped file, values are copied into the document */
+    INI_STAT_START(start);
+    int result = ini_doc_add_section(p_doc, "", 0);
+    if (result >= 0) result = ini_doc_parse_mem(p_doc, p_buf, size);
+    result = ini_doc_finish(p_doc, result, pp_doc);
+    INI_STAT_TIME(open, start);
+    return result;
+}
+
+LIB_EXPORT int
+ini_compile(const char* filename,
+            const char* p_image_name)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    (void)filename; (void)p_image_name;
+    return RET_NOSUP;
+#else
+    char image_name[INI_TMP_NAME_LEN], temp_name[INI_TMP_NAME_LEN];
+    ini_doc_t* p_doc = NULL;
+    int len;
+
+    /* Check input pointers */
+    if (!filename) return RET_NULL;
+    if (!p_image_name) {
+        len = snprintf(image_name, sizeof(image_name), "%s.bin", filename);
+        if (len < 0 || (size_t)len >= sizeof(image_name)) return RET_BUF;
+        p_image_name = image_name;
+    }
+    len = snprintf(temp_name, sizeof(temp_name), "%s.XXXXXX", p_image_name);
+    if (len < 0 || (size_t)len >= sizeof(temp_name)) return RET_BUF;
+
+    /* Always compile from the text, the image records the parsed version */
+    int result = ini_doc_open(filename, 0, &p_doc);
+    if (result < 0) return result;
+    if (p_doc->stamp.ino == 0) { ini_close(p_doc); return RET_VAL; } /* Not a regular file */
+
+    /* Write next to the target and rename, readers never map a partial image */
+    int fd = mkstemp(temp_name);
+    if (fd < 0) { result = RET_ERRNO; ini_close(p_doc); return result; }
+    INI_STAT_ADD(temp_files, 1);
+    FILE* file = fdopen(fd, "wb");
+    if (!file) { result = RET_ERRNO; close(fd); }
+    else {
+        if (fchmod(fd, 0644) != 0) result = RET_ERRNO; /* Shared by all workers */
+        if (result >= 0) result = ini_image_write(p_doc, file);
+        if (result >= 0) INI_STAT_ADD(bytes_written, ftell(file));
+        if (fclose(file) != 0 && result >= 0) result = RET_ERRNO;
+    }
+    if (result >= 0 && rename(temp_name, p_image_name) != 0) result = RET_ERRNO;
+    if (result >= 0) INI_STAT_ADD(renames, 1);
+    if (result < 0) unlink(temp_name);
+    ini_close(p_doc);
+    return result;
+#endif
+}
+
+static int
+ini_doc_get(const ini_doc_t* p_doc,
+            const char* p_section,
+            const char* p_key,
+            char* p_value,
+            size_t value_size)
+{
+    /* Input parameter check */
+    if (!p_doc || !p_section || !p_key || !p_value || value_size == 0) return RET_NULL;
+    p_value[0] = '\0'; /* Empty string for not found */
+
+    size_t i = ini_doc_find(p_doc, p_section, p_key);
+    if (i == INI_NO_ENTRY) return RET_EOF; /* Same as a scan reaching end of file */
+
+    /* Copy and truncate to buffer size */
+    size_t value_len;
+    const char* p_src = ini_doc_value(p_doc, i, &value_len);
+    size_t len = value_len < value_size - 1 ? value_len : value_size - 1;
+    memcpy(p_value, p_src, len);
+    p_value[len] = '\0';
+    return (int)len;
+}
+
+LIB_EXPORT int
+ini_get(const ini_doc_t* p_doc,
+        const char* p_section,
+        const char* p_key,
+        char* p_value,
+        size_t value_size)
+{
+    INI_STAT_START(start);
+    int result = ini_doc_get(p_doc, p_section, p_key, p_value, value_size);
+    INI_STAT_TIME(get, start);
+    return result;
+}
+
+LIB_EXPORT uint64_t
+ini_key_hash(const char* p_section,
+             const char* p_key)
+{
+    if (!p_section || !p_key) return 0;
+    return ini_hash(p_section, strlen(p_section), p_key, strlen(p_key));
+}
+
+LIB_EXPORT int
+ini_get_view(const ini_doc_t* p_doc,
+             const char* p_section,
+             const char* p_key,
+             const char** pp_value,
+             size_t* p_len)
+{
+    /* Input parameter check */
+    if (!p_doc || !p_section || !p_key || !pp_value || !p_len) return RET_NULL;
+
+    size_t i = ini_doc_find(p_doc, p_section, p_key);
+    if (i == INI_NO_ENTRY) return RET_EOF;
+    *pp_value = ini_doc_value(p_doc, i, p_len);
+    return RET_OK;
+}
+
+LIB_EXPORT int
+ini_get_view_hash(const ini_doc_t* p_doc,
+                  uint64_t hash,
+                  const char** pp_value,
+                  size_t* p_len)
+{
+    /* Input parameter check */
+    if (!p_doc || !pp_value || !p_len) return RET_NULL;
+
+    size_t i = ini_doc_find_hash(p_doc, hash);
+    if (i == INI_NO_ENTRY) return RET_EOF;
+    *pp_value = ini_doc_value(p_doc, i, p_len);
+    return RET_OK;
+}
+
+LIB_EXPORT int
+ini_doc_memory(const ini_doc_t* p_doc,
+               ini_doc_mem_t* p_mem)
+{
+    /* Input parameter check */
+    if (!p_doc || !p_mem) return RET_NULL;
+    memset(p_mem, 0, sizeof(*p_mem));
+
+    /* Images hold their strings in the mapping */
+    p_mem->total_bytes = ini_doc_mem_size(p_doc);
+    if (p_doc->p_image) {
+        p_mem->keys = p_doc->p_image->entry_count;
+        p_mem->sections = p_doc->p_image->section_count;
+        p_mem->string_bytes = p_doc->p_image->strings_size;
+    }
+    else {
+        p_mem->keys = p_doc->entry_count;
+        p_mem->sections = p_doc->section_count;
+        p_mem->names = p_doc->name_count;
+        p_mem->string_bytes = p_doc->arena.used;
+        p_mem->arena_bytes = p_doc->arena.reserved;
+    }
+    p_mem->table_bytes = p_mem->total_bytes - sizeof(*p_doc) - p_mem->arena_bytes - (p_doc->p_image ? p_mem->string_bytes : 0);
+    if (p_mem->keys > 0) p_mem->bytes_per_key = (double)p_mem->total_bytes / p_mem->keys;
+    return RET_OK;
+}
+
+LIB_EXPORT int
+ini_get_keys(const ini_doc_t* p_doc,
+             ini_query_t* p_query,
+             size_t count)
+{
+    int found = 0;
+
+    /* Input parameter check */
+    if (!p_doc || (!p_query && count > 0)) return RET_NULL;
+
+    /* Resolve each entry, results are reported per entry */
+    for (size_t i = 0; i < count; ++i) {
+        ini_query_t* p_entry = &p_query[i];
+        p_entry->result = ini_doc_get(p_doc, p_entry->p_section, p_entry->p_key, p_entry->p_value, p_entry->value_size);
+        if (p_entry->result >= 0) ++found;
+    }
+    return found;
+}
+
+/* Locale-independent strtod for values the exact fast path can not handle */
+static double
+ini_strtod_c(const char* p_str,
+             char** pp_end)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    static _Atomic(_locale_t) c_locale;
+    _locale_t locale = atomic_load(&c_locale);
+    if (!locale) {
+        _locale_t created = _create_locale(LC_NUMERIC, "C");
+        if (!created) return strtod(p_str, pp_end);
+        if (atomic_compare_exchange_strong(&c_locale, &locale, created)) locale = created;
+        else _free_locale(created);
+    }
+    return _strtod_l(p_str, pp_end, locale);
+#else
+    static _Atomic(locale_t) c_locale;
+    locale_t locale = atomic_load(&c_locale);
+    if (!locale) {
+        locale_t created = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+        if (!created) return strtod(p_str, pp_end);
+        if (atomic_compare_exchange_strong(&c_locale, &locale, created)) locale = created;
+        else freelocale(created);
+    }
+    locale_t old = uselocale(locale); /* Per-thread, other threads keep their locale */
+    double value = strtod(p_str, pp_end);
+    uselocale(old);
+    return value;
+#endif
+}
+
+/* Parse a decimal floating point prefix, returns the number of characters used or 0 */
+static size_t
+ini_scan_double(const char* p_src,
+                size_t src_len,
+                double* p_value)
+{
+    /* Exactly representable powers of ten for the fast path */
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    size_t i_src = 0;
+    uint64_t mantissa = 0;
+    int digits = 0, scale = 0, exponent = 0, negative = 0;
+
+    if (i_src < src_len && (p_src[i_src] == '-' || p_src[i_src] == '+')) negative = p_src[i_src++] == '-';
+    for (; i_src < src_len && ISDIGIT(p_src[i_src]); ++i_src, ++digits) mantissa = mantissa * 10 + (uint64_t)(p_src[i_src] - '0');
+    if (i_src < src_len && p_src[i_src] == '.') {
+        for (++i_src; i_src < src_len && ISDIGIT(p_src[i_src]); ++i_src, ++digits, --scale) mantissa = mantissa * 10 + (uint64_t)(p_src[i_src] - '0');
+    }
+    if (digits > 0 && i_src < src_len && (p_src[i_src] == 'e' || p_src[i_src] == 'E')) {
+        size_t i_exp = i_src + 1;
+        int exp_negative = 0;
+        if (i_exp < src_len && (p_src[i_exp] == '-' || p_src[i_exp] == '+')) exp_negative = p_src[i_exp++] == '-';
+        if (i_exp < src_len && ISDIGIT(p_src[i_exp])) {
+            for (; i_exp < src_len && ISDIGIT(p_src[i_exp]) && exponent < 10000; ++i_exp) exponent = exponent * 10 + (p_src[i_exp] - '0');
+            if (exp_negative) exponent = -exponent;
+            i_src = i_exp;
+        }
+    }
+    scale += exponent;
+
+    /* Exact when mantissa and power of ten are both exact doubles */
+    if (digits > 0 && digits <= 19 && mantissa <= (1ULL << 53) && scale >= -22 && scale <= 22) {
+        double value = (double)mantissa;
+        value = scale < 0 ? value / pow10[-scale] : value * pow10[scale];
+        *p_value = negative ? -value : value;
+        return i_src;
+    }
+
+    /* Long mantissas, large exponents, inf and nan */
+    char* p_end = NULL;
+    double value = ini_strtod_c(p_src, &p_end);
+    if (p_end == p_src || (size_t)(p_end - p_src) > src_len) return 0;
+    *p_value = value;
+    return (size_t)(p_end - p_src);
+}
+
+static int
+ini_conv_int(const char* p_src,
+             size_t src_len,
+             int64_t* p_value)
+{
+    static const char suffixes[] = "kmgt";
+    size_t i_src = 0;
+    uint64_t value = 0, limit;
+    int negative = 0, base = 10, digits = 0;
+
+    if (i_src < src_len && (p_src[i_src] == '-' || p_src[i_src] == '+')) negative = p_src[i_src++] == '-';
+    if (src_len - i_src >= 3 && p_src[i_src] == '0' && TOLOWER(p_src[i_src + 1]) == 'x') { base = 16; i_src += 2; }
+    limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+
+    for (; i_src < src_len; ++i_src, ++digits) {
+        int c = TOLOWER(p_src[i_src]), digit;
+        if (ISDIGIT(c)) digit = c - '0';
+        else if (base == 16 && c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else break;
+        if (value > (limit - (uint64_t)digit) / (uint64_t)base) return RET_ERRVAL(ERANGE);
+        value = value * (uint64_t)base + (uint64_t)digit;
+    }
+    if (digits == 0) return RET_VAL;
+
+    /* Binary size suffix, 64k = 65536 */
+    if (i_src < src_len) {
+        const char* p_suffix = strchr(suffixes, TOLOWER(p_src[i_src]));
+        if (!p_suffix || *p_suffix == '\0' || i_src + 1 != src_len) return RET_VAL;
+        int shift = 10 * (int)(p_suffix - suffixes + 1);
+        if (value > limit >> shift) return RET_ERRVAL(ERANGE);
+        value <<= shift;
+    }
+    *p_value = negative ? (int64_t)(0 - value) : (int64_t)value;
+    return RET_OK;
+}
+
+static int
+ini_conv_double(const char* p_src,
+                size_t src_len,
+                double* p_value)
+{
+    if (src_len == 0 || ini_scan_double(p_src, src_len, p_value) != src_len) return RET_VAL;
+
+    /* Infinity only when spelled out, a number that overflows is out of range */
+    size_t i_src = p_src[0] == '-' || p_src[0] == '+';
+    if (isinf(*p_value) && i_src < src_len && !ISALPHA(p_src[i_src])) return RET_ERRVAL(ERANGE);
+    return RET_OK;
+}
+
+static int
+ini_conv_bool(const char* p_src,
+              size_t src_len,
+              int* p_value)
+{
+    static const char* const p_words[] = { "false", "no", "off", "0", "disabled", "true", "yes", "on", "1", "enabled" };
+
+    for (size_t i = 0; i < sizeof(p_words) / sizeof(p_words[0]); ++i) {
+        if (ini_name_equal_n(p_words[i], p_src, (int)src_len)) {
+            *p_value = i >= 5;
+            return RET_OK;
+        }
+    }
+    return RET_VAL;
+}
+
+static int
+ini_conv_duration(const char* p_src,
+                  size_t src_len,
+                  int64_t* p_value)
+{
+    /* Longest unit names first */
+    static const struct { const char* p_name; size_t len; int64_t ns; } units[] = {
+        { "ns", 2, 1 }, { "us", 2, 1000 }, { "ms", 2, 1000000 }, { "s", 1, 1000000000 },
+        { "m", 1, 60 * 1000000000LL }, { "h", 1, 3600 * 1000000000LL }, { "d", 1, 86400 * 1000000000LL }
+    };
+    size_t i_src = 0, start;
+    double total = 0;
+    int negative = 0;
+
+    if (i_src < src_len && (p_src[i_src] == '-' || p_src[i_src] == '+')) negative = p_src[i_src++] == '-';
+    if ((start = i_src) == src_len) return RET_VAL;
+
+    /* One or more number and unit pairs, 1h30m, a lone number is seconds */
+    while (i_src < src_len) {
+        double number;
+        if (!ISDIGIT(p_src[i_src]) && p_src[i_src] != '.') return RET_VAL;
+        size_t used = ini_scan_double(p_src + i_src, src_len - i_src, &number);
+        if (used == 0) return RET_VAL;
+        i_src += used;
+
+        int64_t ns = 0;
+        if (i_src == src_len && total == 0 && used == src_len - start) ns = units[3].ns;
+        for (size_t i = 0; ns == 0 && i < sizeof(units) / sizeof(units[0]); ++i) {
+            if (src_len - i_src >= units[i].len && strncmp(p_src + i_src, units[i].p_name, units[i].len) == 0
+                && (units[i].len == 2 || i_src + 1 == src_len || !ISALPHA(p_src[i_src + 1]))) {
+                ns = units[i].ns;
+                i_src += units[i].len;
+            }
+        }
+        if (ns == 0) return RET_VAL;
+        total += number * (double)ns;
+    }
+    if (total >= 9223372036854775807.0) return RET_ERRVAL(ERANGE);
+    *p_value = (int64_t)(total + 0.5) * (negative ? -1 : 1);
+    return RET_OK;
+}
+
+/* Convert an entry once, the first typed access caches its result in the document */
+static int
+ini_get_typed(const ini_doc_t* p_doc,
+              const char* p_section,
+              const char* p_key,
+              unsigned char kind,
+              uint64_t* p_bits)
+{
+    /* Input parameter check */
+    if (!p_doc || !p_section || !p_key) return RET_NULL;
+
+    size_t i = ini_doc_find(p_doc, p_section, p_key);
+    if (i == INI_NO_ENTRY) return RET_EOF;
+
+    /* The conversion cache is the only mutable part of a shared document */
+    struct ini_conv* p_conv = &p_doc->p_conv[i];
+    if (atomic_load_explicit(&p_conv->kind, memory_order_acquire) == kind) {
+        *p_bits = atomic_load_explicit(&p_conv->value, memory_order_relaxed);
+        return RET_OK;
+    }
+
+    int result = RET_VAL;
+    union { int64_t i; double d; uint64_t bits; } value = { 0 };
+    int flag = 0;
+    size_t src_len;
+    const char* p_src = ini_doc_value(p_doc, i, &src_len);
+    switch (kind) {
+        case INI_CONV_INT:      result = ini_conv_int(p_src, src_len, &value.i); break;
+        case INI_CONV_DOUBLE:   result = ini_conv_double(p_src, src_len, &value.d); break;
+        case INI_CONV_BOOL:     result = ini_conv_bool(p_src, src_len, &flag); value.i = flag; break;
+        case INI_CONV_DURATION: result = ini_conv_duration(p_src, src_len, &value.i); break;
+    }
+    if (result < 0) return result;
+
+    /* Claim the empty slot, concurrent or different-typed readers just convert again */
+    unsigned char empty = INI_CONV_NONE;
+    if (atomic_compare_exchange_strong(&p_conv->kind, &empty, INI_CONV_BUSY)) {
+        atomic_store_explicit(&p_conv->value, value.bits, memory_order_relaxed);
+        atomic_store_explicit(&p_conv->kind, kind, memory_order_release);
+    }
+    *p_bits = value.bits;
+    return RET_OK;
+}
+
+LIB_EXPORT int
+ini_get_int(const ini_doc_t* p_doc,
+            const char* p_section,
+            const char* p_key,
+            int64_t* p_value)
+{
+    uint64_t bits;
+    if (!p_value) return RET_NULL;
+    int result = ini_get_typed(p_doc, p_section, p_key, INI_CONV_INT, &bits);
+    if (result == RET_OK) *p_value = (int64_t)bits;
+    return result;
+}
+
+LIB_EXPORT int
+ini_get_double(const ini_doc_t* p_doc,
+               const char* p_section,
+               const char* p_key,
+               double* p_value)
+{
+    uint64_t bits;
+    if (!p_value) return RET_NULL;
+    int result = ini_get_typed(p_doc, p_section, p_key, INI_CONV_DOUBLE, &bits);
+    if (result == RET_OK) memcpy(p_value, &bits, sizeof(*p_value));
+    return result;
+}
+
+LIB_EXPORT int
+ini_get_bool(const ini_doc_t* p_doc,
+             const char* p_section,
+             const char* p_key,
+             int* p_value)
+{
+    uint64_t bits;
+    if (!p_value) return RET_NULL;
+    int result = ini_get_typed(p_doc, p_section, p_key, INI_CONV_BOOL, &bits);
+    if (result == RET_OK) *p_value = (int)bits;
+    return result;
+}
+
+LIB_EXPORT int
+ini_get_duration(const ini_doc_t* p_doc,
+                 const char* p_section,
+                 const char* p_key,
+                 int64_t* p_ns)
+{
+    uint64_t bits;
+    if (!p_ns) return RET_NULL;
+    int result = ini_get_typed(p_doc, p_section, p_key, INI_CONV_DURATION, &bits);
+    if (result == RET_OK) *p_ns = (int64_t)bits;
+    return result;
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+/* Cached document of one path */
+struct ini_cache_entry {
+    char* p_path;
+    uint64_t hash;      /* Hash of path */
+    ini_doc_t* p_doc;
+    size_t mem_size;
+    atomic_ullong last_use; /* For LRU eviction, refreshed by readers */
+};
+
+/* Process-wide parse cache */
+static struct {
+    pthread_rwlock_t lock;  /* Lookups share the read lock */
+    struct ini_cache_entry* p_entries;
+    size_t count;
+    size_t size;
+    size_t mem_size;
+    size_t limit;
+    atomic_ullong tick;     /* Advanced on insert, so hits rarely write */
+    atomic_ullong hits;
+    atomic_ullong misses;
+    uint64_t evictions;
+} ini_cache = { PTHREAD_RWLOCK_INITIALIZER, NULL, 0, 0, 0, INI_CACHE_LIMIT, 0, 0, 0, 0 };
+
+static struct ini_cache_entry*
+ini_cache_find(const char* filename,
+               uint64_t hash)
+{
+    for (size_t i = 0; i < ini_cache.count; ++i) {
+        struct ini_cache_entry* p_entry = &ini_cache.p_entries[i];
+        if (p_entry->hash == hash && strcmp(p_entry->p_path, filename) == 0) return p_entry;
+    }
+    return NULL;
+}
+
+static void
+ini_cache_remove(struct ini_cache_entry* p_entry)
+{
+    ini_cache.mem_size -= p_entry->mem_size;
+    ini_close(p_entry->p_doc);
+    free(p_entry->p_path);
+    *p_entry = ini_cache.p_entries[--ini_cache.count];
+}
+
+static void
+ini_cache_evict(size_t mem_size)
+{
+    /* Evict least recently used until mem_size more fits */
+    while (ini_cache.count > 0 && ini_cache.mem_size + mem_size > ini_cache.limit) {
+        struct ini_cache_entry* p_lru = &ini_cache.p_entries[0];
+        for (size_t i = 1; i < ini_cache.count; ++i) {
+            if (atomic_load(&ini_cache.p_entries[i].last_use) < atomic_load(&p_lru->last_use)) p_lru = &ini_cache.p_entries[i];
+        }
+        ini_cache_remove(p_lru);
+        ini_cache.evictions++;
+    }
+}
+
+static void
+ini_cache_insert(const char* filename,
+                 uint64_t hash,
+                 ini_doc_t* p_doc)
+{
+    size_t mem_size = ini_doc_mem_size(p_doc);
+
+    /* Replace old version of the same path */
+    struct ini_cache_entry* p_entry = ini_cache_find(filename, hash);
+    if (p_entry) ini_cache_remove(p_entry);
+
+    /* Documents larger than the limit are not cached */
+    if (mem_size > ini_cache.limit) { ini_close(p_doc); return; }
+
+    ini_cache_evict(mem_size);
+
+    /* Grow table, a failed insert only means no caching */
+    if (ini_cache.count == ini_cache.size) {
+        size_t size = ini_cache.size ? ini_cache.size * 2 : 8;
+        struct ini_cache_entry* p_entries = realloc(ini_cache.p_entries, size * sizeof(*p_entries));
+        if (!p_entries) { ini_close(p_doc); return; }
+        ini_cache.p_entries = p_entries;
+        ini_cache.size = size;
+    }
+    size_t len = strlen(filename) + 1;
+    char* p_path = malloc(len);
+    if (!p_path) { ini_close(p_doc); return; }
+
+    p_entry = &ini_cache.p_entries[ini_cache.count++];
+    p_entry->p_path = memcpy(p_path, filename, len);
+    p_entry->hash = hash;
+    p_entry->p_doc = p_doc;
+    p_entry->mem_size = mem_size;
+    atomic_init(&p_entry->last_use, atomic_fetch_add(&ini_cache.tick, 1) + 1);
+    ini_cache.mem_size += mem_size;
+}
+
+static void
+ini_cache_drop(const char* filename)
+{
+    pthread_rwlock_wrlock(&ini_cache.lock);
+    struct ini_cache_entry* p_entry = ini_cache_find(filename, ini_hash_str(INI_HASH_OFFSET, filename, strlen(filename)));
+    if (p_entry) ini_cache_remove(p_entry);
+    pthread_rwlock_unlock(&ini_cache.lock);
+}
+
+static int
+ini_cache_query(const char* filename,
+                ini_query_t* p_query,
+                size_t count)
+{
+    struct stat st;
+    struct ini_stamp stamp;
+    ini_doc_t* p_doc = NULL;
+    int result;
+
+    /* One stat validates the cached document */
+    if (stat(filename, &st) != 0) return RET_ERRNO;
+    ini_stamp_set(&stamp, &st);
+    uint64_t hash = ini_hash_str(INI_HASH_OFFSET, filename, strlen(filename));
+
+    pthread_rwlock_rdlock(&ini_cache.lock);
+    struct ini_cache_entry* p_entry = ini_cache_find(filename, hash);
+    if (p_entry && S_ISREG(st.st_mode) && ini_stamp_equal(&p_entry->p_doc->stamp, &stamp)) {
+        atomic_fetch_add_explicit(&ini_cache.hits, 1, memory_order_relaxed);
+        INI_STAT_ADD(cache_hits, 1);
+        /* Only advance the shared tick when the entry is not already the most recent */
+        uint64_t tick = atomic_load_explicit(&ini_cache.tick, memory_order_relaxed);
+        if (atomic_load_explicit(&p_entry->last_use, memory_order_relaxed) != tick) {
+            tick = atomic_fetch_add_explicit(&ini_cache.tick, 1, memory_order_relaxed) + 1;
+            atomic_store_explicit(&p_entry->last_use, tick, memory_order_relaxed);
+        }
+        result = ini_get_keys(p_entry->p_doc, p_query, count);
+        pthread_rwlock_unlock(&ini_cache.lock);
+        return result;
+    }
+    pthread_rwlock_unlock(&ini_cache.lock);
+    atomic_fetch_add_explicit(&ini_cache.misses, 1, memory_order_relaxed);
+    INI_STAT_ADD(cache_misses, 1);
+
+    /* Parse outside the lock, the document carries the stamp of the parsed file */
+    if ((result = ini_doc_open(filename, 1, &p_doc)) < 0) return result;
+    result = ini_get_keys(p_doc, p_query, count);
+    if (p_doc->stamp.ino == 0) { ini_close(p_doc); return result; } /* Not a regular file */
+
+    pthread_rwlock_wrlock(&ini_cache.lock);
+    ini_cache_insert(filename, hash, p_doc);
+    pthread_rwlock_unlock(&ini_cache.lock);
+    return result;
+}
+#endif
+
+LIB_EXPORT void
+ini_cache_flush(void)
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+    pthread_rwlock_wrlock(&ini_cache.lock);
+    while (ini_cache.count > 0) ini_cache_remove(&ini_cache.p_entries[0]);
+    pthread_rwlock_unlock(&ini_cache.lock);
+#endif
+}
+
+LIB_EXPORT void
+ini_cache_limit(size_t limit)
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+    pthread_rwlock_wrlock(&ini_cache.lock);
+    ini_cache.limit = limit;
+    ini_cache_evict(0);
+    pthread_rwlock_unlock(&ini_cache.lock);
+#else
+    (void)limit;
+#endif
+}
+
+LIB_EXPORT void
+ini_cache_stats(ini_cache_stats_t* p_stats)
+{
+    if (!p_stats) return;
+    memset(p_stats, 0, sizeof(*p_stats));
+#if !defined(_WIN32) && !defined(_WIN64)
+    pthread_rwlock_rdlock(&ini_cache.lock);
+    p_stats->hits = atomic_load(&ini_cache.hits);
+    p_stats->misses = atomic_load(&ini_cache.misses);
+    p_stats->evictions = ini_cache.evictions;
+    p_stats->entries = ini_cache.count;
+    p_stats->mem_size = ini_cache.mem_size;
+    p_stats->limit = ini_cache.limit;
+    pthread_rwlock_unlock(&ini_cache.lock);
+#endif
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+/* Write-behind overlay, defined with the writer */
+static uint64_t ini_behind_cycles(void);
+static int ini_behind_read(const char* filename, ini_query_t* p_query, size_t count, int found, uint64_t cycle);
+#endif
+
+LIB_EXPORT int
+ini_read_keys(const char* filename,
+              ini_query_t* p_query,
+              size_t count)
+{
+    /* Input parameter check */
+    if (!filename || (!p_query && count > 0)) return RET_NULL;
+
+    INI_STAT_START(start);
+#if !defined(_WIN32) && !defined(_WIN64)
+    uint64_t cycle = ini_behind_cycles();
+    int result = ini_cache_query(filename, p_query, count);
+    result = ini_behind_read(filename, p_query, count, result, cycle); /* Read your own queued writes */
+#else
+    /* Parse file once and resolve all entries */
+    ini_doc_t* p_doc = NULL;
+    int result = ini_doc_open(filename, 1, &p_doc);
+    if (result >= 0) result = ini_get_keys(p_doc, p_query, count);
+    ini_close(p_doc);
+#endif
+    INI_STAT_TIME(read_key, start);
+    return result;
+}
+
+static int
+ini_image_section(const struct ini_doc* p_doc,
+                  uint64_t hash,
+                  const char* p_section,
+                  ini_section_cb callback,
+                  void* p_user)
+{
+    const struct ini_image* p_image = p_doc->p_image;
+    const struct ini_image_section* p_sections = (const struct ini_image_section*)((const char*)p_image + p_image->sections_off);
+    int found = 0, count = 0;
+
+    /* Sections are few, a linear scan in file order matches the parsed document */
+    for (uint32_t i = 0; i < p_image->section_count; ++i) {
+        const struct ini_image_section* p_sec = &p_sections[i];
+        const char* p_name = ini_image_str(p_image, p_sec->name_off, p_sec->name_len);
+        if (p_sec->hash != hash || !p_name || !ini_name_equal(p_name, p_section)) continue;
+        if (p_sec->first > p_image->entry_count || p_sec->count > p_image->entry_count - p_sec->first) continue;
+        found = 1;
+        for (size_t j = p_sec->first; j < (size_t)p_sec->first + p_sec->count; ++j) {
+            size_t key_len, value_len;
+            const char* p_key = ini_doc_key(p_doc, j, &key_len);
+            const char* p_value = ini_doc_value(p_doc, j, &value_len);
+            ++count;
+            if (callback(p_key, key_len, p_value, value_len, p_user)) return count;
+        }
+    }
+    return found ? count : RET_EOF;
+}
+
+LIB_EXPORT int
+ini_doc_section(const ini_doc_t* p_doc,
+                const char* p_section,
+                ini_section_cb callback,
+                void* p_user)
+{
+    int found = 0, count = 0;
+
+    /* Input parameter check */
+    if (!p_doc || !p_section || !callback) return RET_NULL;
+
+    /* Visit all headers with this name, entries are views into the document */
+    size_t section_len = strlen(p_section);
+    uint64_t hash = ini_hash_str(INI_HASH_OFFSET, p_section, section_len);
+    if (p_doc->p_image) return ini_image_section(p_doc, hash, p_section, callback, p_user);
+    size_t i = p_doc->p_section_buckets[hash & (p_doc->section_bucket_count - 1)];
+    for (; i != INI_NO_ENTRY; i = p_doc->p_sections[i].next) {
+        const struct ini_section* p_sec = &p_doc->p_sections[i];
+        if (p_sec->hash != hash || !ini_name_is(p_sec->p_name, p_section, section_len)) continue;
+        found = 1;
+        for (size_t j = p_sec->first; j < p_sec->first + p_sec->count; ++j) {
+            const struct ini_entry* p_entry = &p_doc->p_entries[j];
+            ++count;
+            if (callback(p_entry->p_key->text, p_entry->p_key->len, p_entry->p_value, p_entry->value_len, p_user)) return count;
+        }
+    }
+    return found ? count : RET_EOF;
+}
+
+LIB_EXPORT int
+ini_get_section(const char* filename,
+                const char* p_section,
+                ini_section_cb callback,
+                void* p_user)
+{
+    ini_doc_t* p_doc = NULL;
+
+    /* Input parameter check */
+    if (!filename || !p_section || !callback) return RET_NULL;
+
+    /* Parse file once and enumerate the section */
+    int result = ini_open(filename, &p_doc);
+    if (result < 0) return result;
+    result = ini_doc_section(p_doc, p_section, callback, p_user);
+    ini_close(p_doc);
+    return result;
+}
+
+LIB_EXPORT int
+ini_get_section_mem(const char* p_buf,
+                    size_t size,
+                    const char* p_section,
+                    ini_section_cb callback,
+                    void* p_user)
+{
+    ini_doc_t* p_doc = NULL;
+
+    /* Input parameter check */
+    if (!p_buf || !p_section || !callback) return RET_NULL;
+
+    /* Duplicate sections are merged like in a file */
+    int result = ini_open_mem(p_buf, size, &p_doc);
+    if (result < 0) return result;
+    result = ini_doc_section(p_doc, p_section, callback, p_user);
+    ini_close(p_doc);
+    return result;
+}
+
+/* Stream parser state between lines */
+struct ini_stream {
+    const ini_handler_t* p_handler;
+    void* p_user;
+    const char* p_section;      /* Current section name */
+    size_t section_len;
+    struct ini_line section;    /* Section copy when lines are not kept */
+    struct ini_line value;      /* Decoded quoted value */
+    int in_memory;              /* Lines stay valid, sections are views */
+    size_t line_no;
+    int count;                  /* Key/value pairs visited */
+};
+
+/* Returns 1 to stop, 0 to continue or negative error code */
+static int
+ini_stream_line(struct ini_stream* p_stream,
+                const char* p_line,
+                size_t len,
+                const struct ini_tokens* p_tok)
+{
+    const ini_handler_t* p_handler = p_stream->p_handler;
+    struct ini_parts parts;
+    int result;
+
+    ++p_stream->line_no;
+    switch (ini_split_line(p_line, len, p_tok, &parts)) {
+        case INI_KIND_COMMENT:
+            return p_handler->on_comment && p_handler->on_comment(parts.p_name, parts.name_len, p_stream->p_user) ? 1 : 0;
+        case INI_KIND_SECTION:
+            p_stream->p_section = parts.p_name;
+            p_stream->section_len = parts.name_len;
+            if (!p_stream->in_memory) {
+                result = ini_line_set(&p_stream->section, parts.p_name, parts.name_len);
+                if (result < 0) return result;
+                p_stream->p_section = p_stream->section.p_buf;
+            }
+            return p_handler->on_section && p_handler->on_section(parts.p_name, parts.name_len, p_stream->p_user) ? 1 : 0;
+        case INI_KIND_QUOTED:
+            /* Decoded value is never longer than the quoted one */
+            result = ini_line_reserve(&p_stream->value, parts.value_len + 1);
+            if (result < 0) return result;
+            parts.value_len = (size_t)ini_parse_value(parts.p_value, parts.value_len, p_stream->value.p_buf, p_stream->value.size);
+            parts.p_value = p_stream->value.p_buf;
+            /* fall through */
+        case INI_KIND_KEY:
+            ++p_stream->count;
+            return p_handler->on_key && p_handler->on_key(p_stream->p_section, p_stream->section_len,
+                                                          parts.p_name, parts.name_len,
+                                                          parts.p_value, parts.value_len, p_stream->p_user) ? 1 : 0;
+        case INI_KIND_BAD:
+            return p_handler->on_error && p_handler->on_error(p_stream->line_no, p_line, len, p_stream->p_user) ? 1 : 0;
+        default:
+            return 0;
+    }
+}
+
+LIB_EXPORT int
+ini_parse_stream(FILE* file,
+                 const ini_handler_t* p_handler,
+                 void* p_user)
+{
+    struct ini_stream stream = { p_handler, p_user, "", 0, { 0 }, { 0 }, 0, 0, 0 };
+    struct ini_line line;
+    int len, result = RET_OK;
+    ini_scan_fn scan = ini_scan_select();
+    struct ini_tokens tok;
+
+    /* Input parameter check */
+    if (!file || !p_handler) return RET_NULL;
+
+    ini_line_init(&line);
+    ini_line_init(&stream.section);
+    ini_line_init(&stream.value);
+
+    /* One line in memory at a time */
+    while ((len = ini_readln(file, &line)) >= 0) {
+        INI_STAT_ADD(lines_scanned, 1);
+        INI_STAT_ADD(bytes_read, len + 1);
+        scan(line.p_buf, len, &tok);
+        result = ini_stream_line(&stream, line.p_buf, len, &tok);
+        if (result != 0) break;
+    }
+    if (result == 0 && len != RET_EOF) result = len;
+    ini_line_free(&line);
+    ini_line_free(&stream.section);
+    ini_line_free(&stream.value);
+    return result < 0 ? result : stream.count;
+}
+
+LIB_EXPORT int
+ini_parse_buffer(const char* p_buf,
+                 size_t size,
+                 const ini_handler_t* p_handler,
+                 void* p_user)
+{
+    struct ini_stream stream = { p_handler, p_user, "", 0, { 0 }, { 0 }, 1, 0, 0 };
+    const char* p_end = p_buf + size;
+    int result = RET_OK;
+    ini_scan_fn scan = ini_scan_select();
+    struct ini_tokens tok;
+    size_t lines = 0;
+
+    /* Input parameter check */
+    if (!p_buf || !p_handler) return RET_NULL;
+
+    ini_line_init(&stream.section);
+    ini_line_init(&stream.value);
+
+    /* Tokenize in place, unquoted values are views into the buffer */
+    INI_STAT_ADD(bytes_read, size);
+    for (; p_buf < p_end; ++lines) {
+        scan(p_buf, p_end - p_buf, &tok);
+        size_t len = tok.eol;
+        if (len > 0 && p_buf[len - 1] == '\r') --len;
+
+        result = ini_stream_line(&stream, p_buf, len, &tok);
+        if (result != 0) { ++lines; break; }
+        if (tok.eol == (size_t)(p_end - p_buf)) { ++lines; break; } /* No newline at EOF */
+        p_buf += tok.eol + 1;
+    }
+    INI_STAT_ADD(lines_scanned, lines);
+    (void)lines;
+    ini_line_free(&stream.value);
+    return result < 0 ? result : stream.count;
+}
+
+LIB_EXPORT int
+ini_parse_file(const char* filename,
+               const ini_handler_t* p_handler,
+               void* p_user)
+{
+    /* Input parameter check */
+    if (!filename || !p_handler) return RET_NULL;
+
+    FILE* file = fopen(filename, "r");
+    if (!file) return RET_ERRNO;
+    INI_STAT_ADD(files_opened, 1);
+    int result = ini_parse_stream(file, p_handler, p_user);
+    fclose(file);
+    return result;
+}
+
+/* Lookup state of ini_read_keys_mem() */
+struct ini_mem_query {
+    ini_query_t* p_query;
+    size_t count;
+    size_t missing;     /* Valid entries not found yet */
+};
+
+static int
+ini_mem_query_key(const char* p_section,
+                  size_t section_len,
+                  const char* p_key,
+                  size_t key_len,
+                  const char* p_value,
+                  size_t value_len,
+                  void* p_user)
+{
+    struct ini_mem_query* p_mem = p_user;
+
+    /* First key wins like in a document, stop once all are found */
+    for (size_t i = 0; i < p_mem->count; ++i) {
+        ini_query_t* p_entry = &p_mem->p_query[i];
+        if (p_entry->result != RET_EOF) continue;
+        if (!ini_name_equal_n(p_entry->p_key, p_key, (int)key_len) ||
+            !ini_name_equal_n(p_entry->p_section, p_section, (int)section_len)) continue;
+        size_t len = value_len < p_entry->value_size - 1 ? value_len : p_entry->value_size - 1;
+        memcpy(p_entry->p_value, p_value, len);
+        p_entry->p_value[len] = '\0';
+        p_entry->result = (int)len;
+        --p_mem->missing;
+    }
+    return p_mem->missing == 0;
+}
+
+LIB_EXPORT int
+ini_read_keys_mem(const char* p_buf,
+                  size_t size,
+                  ini_query_t* p_query,
+                  size_t count)
+{
+    static const ini_handler_t handler = { NULL, ini_mem_query_key, NULL, NULL };
+    struct ini_mem_query mem = { p_query, count, 0 };
+
+    /* Input parameter check */
+    if (!p_buf || (!p_query && count > 0)) return RET_NULL;
+
+    /* Invalid entries fail alone, like ini_get_keys() */
+    for (size_t i = 0; i < count; ++i) {
+        ini_query_t* p_entry = &p_query[i];
+        if (!p_entry->p_section || !p_entry->p_key || !p_entry->p_value || p_entry->value_size == 0) {
+            p_entry->result = RET_NULL;
+            continue;
+        }
+        p_entry->p_value[0] = '\0';
+        p_entry->result = RET_EOF;
+        ++mem.missing;
+    }
+
+    /* One pass without building a document */
+    INI_STAT_START(start);
+    int result = mem.missing ? ini_parse_buffer(p_buf, size, &handler, &mem) : RET_OK;
+    INI_STAT_TIME(read_key, start);
+    if (result < 0) return result;
+
+    int found = 0;
+    for (size_t i = 0; i < count; ++i) found += p_query[i].result >= 0;
+    return found;
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+/* File watcher publishing immutable snapshots */
+struct ini_watch {
+    _Atomic(ini_doc_t*) p_doc;  /* Current snapshot */
+    atomic_uint epoch;          /* Reader counter in use, flipped by the writer */
+    struct {
+        _Alignas(64) atomic_ulong count;
+    } readers[2];               /* Active readers per epoch */
+    atomic_ulong generation;    /* Number of published reloads */
+    char* p_path;
+    const char* p_name;         /* File name part of p_path */
+    int notify_fd;              /* inotify descriptor or -1 */
+    int stop_fd[2];             /* Pipe waking the thread on stop */
+    pthread_t thread;
+};
+
+static void
+ini_watch_publish(struct ini_watch* p_watch,
+                  ini_doc_t* p_doc)
+{
+    ini_doc_t* p_old = atomic_exchange(&p_watch->p_doc, p_doc);
+    atomic_fetch_add(&p_watch->generation, 1);
+
+    /* Flip twice, waiting for both reader counters to drain. A reader that
+     * could have loaded the old pointer registered before the exchange. */
+    for (int i = 0; i < 2; ++i) {
+        unsigned epoch = atomic_fetch_xor(&p_watch->epoch, 1) & 1;
+        while (atomic_load(&p_watch->readers[epoch].count) != 0) sched_yield();
+    }
+    ini_close(p_old);
+}
+
+static void
+ini_watch_reload(struct ini_watch* p_watch)
+{
+    struct stat st;
+    struct ini_stamp stamp;
+    ini_doc_t* p_doc = NULL;
+
+    /* Only the writer thread replaces the snapshot, reading it here is safe */
+    if (stat(p_watch->p_path, &st) != 0) return; /* Keep last snapshot while missing */
+    ini_stamp_set(&stamp, &st);
+    if (ini_stamp_equal(&stamp, &atomic_load(&p_watch->p_doc)->stamp)) return;
+
+    /* A failed parse keeps the previous snapshot */
+    if (ini_open(p_watch->p_path, &p_doc) < 0) return;
+    ini_watch_publish(p_watch, p_doc);
+}
+
+static void*
+ini_watch_thread(void* p_arg)
+{
+    struct ini_watch* p_watch = p_arg;
+    struct pollfd fds[2] = { { p_watch->stop_fd[0], POLLIN, 0 }, { p_watch->notify_fd, POLLIN, 0 } };
+    int timeout = p_watch->notify_fd >= 0 ? -1 : INI_WATCH_POLL_MS;
+
+    for (;;) {
+        int result = poll(fds, p_watch->notify_fd >= 0 ? 2 : 1, timeout);
+        if (result < 0 && errno != EINTR) break;
+        if (fds[0].revents) break; /* Stop requested */
+#if defined(__linux__)
+        if (fds[1].revents) {
+            /* Drain events, any event for our name triggers a reload check */
+            char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+            ssize_t len = read(p_watch->notify_fd, events, sizeof(events));
+            int changed = 0;
+            for (ssize_t i = 0; i < len; ) {
+                const struct inotify_event* p_event = (const struct inotify_event*)(events + i);
+                if (p_event->len && strcmp(p_event->name, p_watch->p_name) == 0) changed = 1;
+                i += sizeof(*p_event) + p_event->len;
+            }
+            if (!changed) continue;
+        }
+#endif
+        ini_watch_reload(p_watch);
+    }
+    return NULL;
+}
+
+LIB_EXPORT int
+ini_watch_start(const char* filename,
+                ini_watch_t** pp_watch)
+{
+    ini_doc_t* p_doc = NULL;
+    int result;
+
+    /* Input parameter check */
+    if (!filename || !pp_watch) return RET_NULL;
+    *pp_watch = NULL;
+
+    struct ini_watch* p_watch = calloc(1, sizeof(*p_watch));
+    if (!p_watch) return RET_ERRNO;
+    p_watch->notify_fd = p_watch->stop_fd[0] = p_watch->stop_fd[1] = -1;
+
+    /* Keep path, the directory is watched since writers replace the file */
+    size_t len = strlen(filename) + 1;
+    if (!(p_watch->p_path = malloc(len))) { result = RET_ERRNO; goto cleanup; }
+    memcpy(p_watch->p_path, filename, len);
+    const char* p_slash = strrchr(p_watch->p_path, '/');
+    p_watch->p_name = p_slash ? p_slash + 1 : p_watch->p_path;
+
+    /* First snapshot */
+    if ((result = ini_open(filename, &p_doc)) < 0) goto cleanup;
+    atomic_init(&p_watch->p_doc, p_doc);
+    if (pipe(p_watch->stop_fd) != 0) { result = RET_ERRNO; goto cleanup; }
+
+#if defined(__linux__)
+    char dir[INI_TMP_NAME_LEN];
+    if ((result = ini_path_dir(p_watch->p_path, dir, sizeof(dir))) < 0) goto cleanup;
+    p_watch->notify_fd = inotify_init1(IN_CLOEXEC);
+    if (p_watch->notify_fd < 0) { result = RET_ERRNO; goto cleanup; }
+    if (inotify_add_watch(p_watch->notify_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        result = RET_ERRNO;
+        goto cleanup;
+    }
+#endif
+
+    if ((result = pthread_create(&p_watch->thread, NULL, ini_watch_thread, p_watch)) != 0) {
+        result = RET_ERRVAL(result);
+        goto cleanup;
+    }
+    *pp_watch = p_watch;
+    return RET_OK;
+
+cleanup:
+    if (p_watch->notify_fd >= 0) close(p_watch->notify_fd);
+    if (p_watch->stop_fd[0] >= 0) { close(p_watch->stop_fd[0]); close(p_watch->stop_fd[1]); }
+    ini_close(p_doc);
+    free(p_watch->p_path);
+    free(p_watch);
+    return result;
+}
+
+LIB_EXPORT void
+ini_watch_stop(ini_watch_t* p_watch)
+{
+    if (!p_watch) return;
+
+    /* Wake and join the thread, readers must be done */
+    if (write(p_watch->stop_fd[1], "", 1) < 0) { /* Pipe is never full */ }
+    pthread_join(p_watch->thread, NULL);
+    if (p_watch->notify_fd >= 0) close(p_watch->notify_fd);
+    close(p_watch->stop_fd[0]);
+    close(p_watch->stop_fd[1]);
+    ini_close(atomic_load(&p_watch->p_doc));
+    free(p_watch->p_path);
+    free(p_watch);
+}
+
+LIB_EXPORT int
+ini_watch_acquire(ini_watch_t* p_watch,
+                  const ini_doc_t** pp_doc)
+{
+    /* Register in the current epoch before loading the pointer */
+    unsigned epoch = atomic_load(&p_watch->epoch) & 1;
+    atomic_fetch_add(&p_watch->readers[epoch].count, 1);
+    *pp_doc = atomic_load(&p_watch->p_doc);
+    return (int)epoch;
+}
+
+LIB_EXPORT void
+ini_watch_release(ini_watch_t* p_watch,
+                  int token)
+{
+    atomic_fetch_sub(&p_watch->readers[token & 1].count, 1);
+}
+
+LIB_EXPORT uint64_t
+ini_watch_generation(ini_watch_t* p_watch)
+{
+    return atomic_load(&p_watch->generation);
+}
+#else
+LIB_EXPORT int
+ini_watch_start(const char* filename,
+                ini_watch_t** pp_watch)
+{
+    (void)filename;
+    if (pp_watch) *pp_watch = NULL;
+    return RET_NOSUP;
+}
+
+LIB_EXPORT void
+ini_watch_stop(ini_watch_t* p_watch)
+{
+    (void)p_watch;
+}
+
+LIB_EXPORT int
+ini_watch_acquire(ini_watch_t* p_watch,
+                  const ini_doc_t** pp_doc)
+{
+    (void)p_watch;
+    *pp_doc = NULL;
+    return RET_NOSUP;
+}
+
+LIB_EXPORT void
+ini_watch_release(ini_watch_t* p_watch,
+                  int token)
+{
+    (void)p_watch; (void)token;
+}
+
+LIB_EXPORT uint64_t
+ini_watch_generation(ini_watch_t* p_watch)
+{
+    (void)p_watch;
+    return 0;
+}
+#endif
+
+LIB_EXPORT int
+ini_read_key(const char* filename,
+             const char* p_section,
+             const char* p_key,
+             char* p_value,
+             size_t value_size) 
+{
+    /* Input parameter check */
+    if (!filename || !p_section || !p_key || !p_value || value_size == 0) return -1; /* Invalid parameters */
+    p_value[0] = '\0'; /* Empty string for not found */
+
+    /* Look up key through the parse cache */
+    ini_query_t query = { p_section, p_key, p_value, value_size, 0 };
+    int result = ini_read_keys(filename, &query, 1);
+    return result < 0 ? result : query.result;
+}
+
+LIB_EXPORT int
+ini_read_key_mem(const char* p_buf,
+                 size_t size,
+                 const char* p_section,
+                 const char* p_key,
+                 char* p_value,
+                 size_t value_size)
+{
+    /* Input parameter check */
+    if (!p_buf || !p_section || !p_key || !p_value || value_size == 0) return RET_NULL;
+
+    ini_query_t query = { p_section, p_key, p_value, value_size, 0 };
+    int result = ini_read_keys_mem(p_buf, size, &query, 1);
+    return result < 0 ? result : query.result;
+}
+
+/* Pending transaction operation */
+struct ini_op {
+    char* p_section;    /* Section name, start of the op allocation */
+    char* p_key;        /* Key name */
+    char* p_value;      /* New value or NULL to delete the key */
+    char* p_comment;    /* Comment for new keys or NULL */
+    int done;           /* Set when written or deleted */
+    int64_t line_off;   /* In-place patch: offset of the key line */
+    size_t line_len;    /* In-place patch: line length without newline */
+};
+
+/* Write transaction */
+struct ini_txn {
+    char* p_filename;
+    struct ini_op* p_ops;
+    size_t op_count;
+    size_t op_size;
+    unsigned options;   /* INI_WRITE_* */
+};
+
+static atomic_uint ini_write_default;
+
+static struct ini_op*
+ini_txn_find(struct ini_txn* p_txn,
+             const char* p_section,
+             const char* p_key,
+             int key_len)
+{
+    for (size_t i = 0; i < p_txn->op_count; ++i) {
+        struct ini_op* p_op = &p_txn->p_ops[i];
+        if (ini_name_equal(p_op->p_section, p_section)
+            && ini_name_equal_n(p_op->p_key, p_key, key_len)) return p_op;
+    }
+    return NULL;
+}
+
+static int
+ini_txn_add(struct ini_txn* p_txn,
+            const char* p_section,
+            const char* p_key,
+            const char* p_value,
+            const char* p_comment)
+{
+    /* Check input pointers */
+    if (!p_txn || !p_section || !p_key) return RET_NULL;
+
+    /* One allocation holds all strings of the op */
+    size_t section_size = strlen(p_section) + 1, key_size = strlen(p_key) + 1;
+    size_t value_len = p_value ? strlen(p_value) : 0;
+    size_t value_size = p_value ? ini_encode_size(p_value, value_len) + 1 : 0; /* As written */
+    size_t comment_size = p_comment ? strlen(p_comment) + 1 : 0;
+    char* p_mem = malloc(section_size + key_size + value_size + comment_size);
+    if (!p_mem) return RET_ERRNO;
+
+    /* Later operations on the same key replace earlier ones */
+    struct ini_op* p_op = ini_txn_find(p_txn, p_section, p_key, (int)key_size - 1);
+    if (p_op) free(p_op->p_section);
+    else {
+        if (p_txn->op_count == p_txn->op_size) {
+            size_t size = p_txn->op_size ? p_txn->op_size * 2 : 8;
+            struct ini_op* p_ops = realloc(p_txn->p_ops, size * sizeof(*p_ops));
+            if (!p_ops) { free(p_mem); return RET_ERRNO; }
+            p_txn->p_ops = p_ops;
+            p_txn->op_size = size;
+        }
+        p_op = &p_txn->p_ops[p_txn->op_count++];
+    }
+
+    p_op->p_section = memcpy(p_mem, p_section, section_size);
+    p_op->p_key = memcpy(p_mem + section_size, p_key, key_size);
+    p_mem += section_size + key_size;
+    p_op->p_value = p_value ? p_mem : NULL;
+    if (p_value && value_size == value_len + 1) memcpy(p_mem, p_value, value_size);
+    else if (p_value) ini_encode_value(p_value, value_len, p_mem);
+    p_op->p_comment = p_comment ? memcpy(p_mem + value_size, p_comment, comment_size) : NULL;
+    p_op->done = 0;
+    return RET_OK;
+}
+
+static int
+ini_txn_write_keys(struct ini_txn* p_txn,
+                   FILE* file_out,
+                   const char* p_eol,
+                   const char* p_section)
+{
+    int result;
+
+    /* Append keys not found in the section, deletes of missing keys are done */
+    for (size_t i = 0; i < p_txn->op_count; ++i) {
+        struct ini_op* p_op = &p_txn->p_ops[i];
+        if (p_op->done || !ini_name_equal(p_op->p_section, p_section)) continue;
+        p_op->done = 1;
+        if (!p_op->p_value) continue;
+        if ((result = ini_write_value(file_out, p_eol, p_op->p_key, p_op->p_value, p_op->p_comment)) < 0) return result;
+    }
+    return RET_OK;
+}
+
+static int
+ini_txn_write(struct ini_txn* p_txn,
+              FILE* file_in,
+              FILE* file_out)
+{
+    struct ini_line line, section;
+    struct ini_parts parts;
+    int len = RET_EOF, result = RET_OK, blank_lines = 0;
+    ini_scan_fn scan = ini_scan_select();
+
+    ini_line_init(&line);
+    ini_line_init(&section);
+
+    /* Stream input once and apply all operations */
+    while (file_in && (len = ini_readln(file_in, &line)) >= 0) {
+        const char* buffer = line.p_buf;
+        INI_STAT_ADD(lines_scanned, 1);
+        INI_STAT_ADD(bytes_read, len + 1);
+
+        /* Defer blank lines so new keys stay next to the section content */
+        int kind = ini_classify_line(scan, buffer, (size_t)len, &parts);
+        if (kind == INI_KIND_BLANK) { ++blank_lines; continue; }
+
+        if (kind == INI_KIND_SECTION) {
+            /* New keys go to the end of the section being left */
+            if ((result = ini_txn_write_keys(p_txn, file_out, "\n", section.p_buf)) < 0) goto cleanup;
+            if ((result = ini_line_set(&section, parts.p_name, parts.name_len)) < 0) goto cleanup;
+        }
+        else if (kind == INI_KIND_KEY || kind == INI_KIND_QUOTED) {
+            struct ini_op* p_op = ini_txn_find(p_txn, section.p_buf, parts.p_name, (int)parts.name_len);
+            if (p_op && !p_op->p_value) { p_op->done = 1; continue; } /* Delete key line */
+            if (p_op && !p_op->done) { /* Update key, old inline comment is removed */
+                for (; blank_lines > 0; --blank_lines) if ((result = ini_writeln(file_out, "")) < 0) goto cleanup;
+                if ((result = ini_write_value(file_out, "\n", p_op->p_key, p_op->p_value, NULL)) < 0) goto cleanup;
+                p_op->done = 1;
+                continue;
+            }
+        }
+
+        /* Copy line to output */
+        for (; blank_lines > 0; --blank_lines) if ((result = ini_writeln(file_out, "")) < 0) goto cleanup;
+        if ((result = ini_writeln(file_out, buffer)) < 0) goto cleanup;
+    }
+    if (len != RET_EOF) { result = len; goto cleanup; } /* Read error */
+
+    /* End of last section */
+    if ((result = ini_txn_write_keys(p_txn, file_out, "\n", section.p_buf)) < 0) goto cleanup;
+    for (; blank_lines > 0; --blank_lines) if ((result = ini_writeln(file_out, "")) < 0) goto cleanup;
+
+    /* New sections go to the end of the file, the header of a new file ends with a blank line */
+    const char* p_fmt = file_in ? "\n[%s]" : "[%s]";
+    for (size_t i = 0; i < p_txn->op_count; ++i) {
+        struct ini_op* p_op = &p_txn->p_ops[i];
+        if (p_op->done || !p_op->p_value) continue;
+        if ((result = ini_writef(file_out, "\n", p_fmt, p_op->p_section)) < 0) goto cleanup;
+        p_fmt = "\n[%s]";
+        if ((result = ini_txn_write_keys(p_txn, file_out, "\n", p_op->p_section)) < 0) goto cleanup;
+    }
+
+cleanup:
+    ini_line_free(&line);
+    ini_line_free(&section);
+    return result < 0 ? result : RET_OK;
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+/* Rewrite output, unchanged source ranges are copied between files */
+struct ini_copy {
+    int fd_in;
+    const char* p_map;  /* Source mapping */
+    FILE* file_out;
+    const char* p_eol;  /* Line ending of the source, for emitted lines */
+    size_t start;       /* Source bytes before start are written */
+    int newline;        /* Output ends with a newline */
+    int blank_lines;    /* Deferred blank lines from before deleted keys */
+};
+
+static int
+ini_copy_blanks(struct ini_copy* p_copy)
+{
+    for (; p_copy->blank_lines > 0; --p_copy->blank_lines) {
+        if (fputs(p_copy->p_eol, p_copy->file_out) == EOF) return RET_ERRNO;
+    }
+    return RET_OK;
+}
+
+static int
+ini_copy_to(struct ini_copy* p_copy,
+            size_t end)
+{
+    size_t done = p_copy->start;
+    if (end <= done) return RET_OK;
+    int result = ini_copy_blanks(p_copy);
+    if (result < 0) return result;
+    if (fflush(p_copy->file_out) != 0) return RET_ERRNO;
+    int fd_out = fileno(p_copy->file_out);
+
+#if defined(__linux__)
+    /* In kernel copy, the file system may share extents instead */
+    loff_t off_in = (loff_t)done;
+    while (done < end) {
+        ssize_t n = copy_file_range(p_copy->fd_in, &off_in, fd_out, NULL, end - done, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break; /* Not supported here, write from the mapping */
+        done += (size_t)n;
+    }
+#endif
+    while (done < end) {
+        ssize_t n = write(fd_out, p_copy->p_map + done, end - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return RET_ERRNO;
+        done += (size_t)n;
+    }
+    p_copy->newline = p_copy->p_map[end - 1] == '\n';
+    p_copy->start = end;
+    return RET_OK;
+}
+
+static int
+ini_copy_break(struct ini_copy* p_copy)
+{
+    /* Formatted lines never continue a copied last line without newline */
+    if (!p_copy->newline && fputs(p_copy->p_eol, p_copy->file_out) == EOF) return RET_ERRNO;
+    p_copy->newline = 1;
+    return RET_OK;
+}
+
+static int
+ini_txn_has_keys(const struct ini_txn* p_txn,
+                 const char* p_section)
+{
+    for (size_t i = 0; i < p_txn->op_count; ++i) {
+        const struct ini_op* p_op = &p_txn->p_ops[i];
+        if (!p_op->done && ini_name_equal(p_op->p_section, p_section)) return 1;
+    }
+    return 0;
+}
+
+static int
+ini_txn_section_ops(const struct ini_txn* p_txn,
+                    const char* p_section)
+{
+    for (size_t i = 0; i < p_txn->op_count; ++i) {
+        const struct ini_op* p_op = &p_txn->p_ops[i];
+        if ((!p_op->p_value || !p_op->done) && ini_name_equal(p_op->p_section, p_section)) return 1;
+    }
+    return 0;
+}
+
+static size_t
+ini_next_header(const char* p_map,
+                size_t size,
+                size_t off)
+{
+    /* Start of the next line whose first non-blank character is '[', off is a line start */
+    while (off < size) {
+        const char* p_open = memchr(p_map + off, '[', size - off);
+        if (!p_open) return size;
+        size_t line = (size_t)(p_open - p_map);
+        while (line > off && ISSPACE(p_map[line - 1])) --line;
+        if (line == off || p_map[line - 1] == '\n') return line;
+        off = (size_t)(p_open - p_map) + 1;
+    }
+    return size;
+}
+
+static int
+ini_txn_pending(const struct ini_txn* p_txn)
+{
+    /* Deletes apply to every matching line, sets to the first one */
+    for (size_t i = 0; i < p_txn->op_count; ++i) {
+        if (!p_txn->p_ops[i].p_value || !p_txn->p_ops[i].done) return 1;
+    }
+    return 0;
+}
+
+static int
+ini_txn_write_mem(struct ini_txn* p_txn,
+                  int fd_in,
+                  const char* p_map,
+                  size_t size,
+                  FILE* file_out)
+{
+    const char* p_first = memchr(p_map, '\n', size);
+    struct ini_copy copy = { fd_in, p_map, file_out, "\n", 0, 1, 0 };
+    struct ini_line section;
+    struct ini_parts parts;
+    ini_scan_fn scan = ini_scan_select();
+    size_t blank_start = INI_NO_TOKEN, lines = 0, off = 0;
+    int result = RET_OK, section_ops = ini_txn_section_ops(p_txn, "");
+
+    ini_line_init(&section);
+
+    /* Emitted lines end like the first line, a CRLF file stays CRLF */
+    if (p_first && p_first > p_map && p_first[-1] == '\r') copy.p_eol = "\r\n";
+
+    /* Same decisions as ini_txn_write(), but untouched lines are copied in ranges */
+    for (; off < size; ++lines) {
+        /* Sections without operations are skipped, not split into lines */
+        if (!section_ops) {
+            off = ini_next_header(p_map, size, off);
+            blank_start = INI_NO_TOKEN;
+            if (off == size) break;
+        }
+        const char* p_buf = p_map + off;
+        const char* p_eol = memchr(p_buf, '\n', size - off);
+        size_t len = p_eol ? (size_t)(p_eol - p_buf) : size - off;
+        size_t line_off = off;
+        off = p_eol ? off + len + 1 : size;
+        if (len > 0 && p_buf[len - 1] == '\r') --len;
+        if (len > INT32_MAX) { result = RET_BUF; goto cleanup; }
+
+        /* Defer blank lines so new keys stay next to the section content */
+        int kind = ini_classify_line(scan, p_buf, len, &parts);
+        if (kind == INI_KIND_BLANK) {
+            if (blank_start == INI_NO_TOKEN) blank_start = line_off;
+            continue;
+        }
+
+        if (kind == INI_KIND_SECTION) {
+            /* New keys go to the end of the section being left */
+            if (ini_txn_has_keys(p_txn, section.p_buf)) {
+                if ((result = ini_copy_to(&copy, blank_start != INI_NO_TOKEN ? blank_start : line_off)) < 0) goto cleanup;
+                if ((result = ini_copy_break(&copy)) < 0) goto cleanup;
+                if ((result = ini_txn_write_keys(p_txn, file_out, copy.p_eol, section.p_buf)) < 0) goto cleanup;
+            }
+            if ((result = ini_line_set(&section, parts.p_name, parts.name_len)) < 0) goto cleanup;
+            if (!ini_txn_pending(p_txn)) break; /* The rest is copied as is */
+            section_ops = ini_txn_section_ops(p_txn, section.p_buf);
+        }
+        else if (kind == INI_KIND_KEY || kind == INI_KIND_QUOTED) {
+            struct ini_op* p_op = ini_txn_find(p_txn, section.p_buf, parts.p_name, (int)parts.name_len);
+            if (p_op && !p_op->p_value) { /* Delete key line, blank lines before it stay deferred */
+                size_t end = blank_start != INI_NO_TOKEN ? blank_start : line_off;
+                if ((result = ini_copy_to(&copy, end)) < 0) goto cleanup;
+                for (; end < line_off; ++end) copy.blank_lines += p_map[end] == '\n';
+                p_op->done = 1;
+                copy.start = off;
+                blank_start = INI_NO_TOKEN;
+                continue;
+            }
+            if (p_op && !p_op->done) { /* Update key, old inline comment is removed */
+                if ((result = ini_copy_to(&copy, line_off)) < 0) goto cleanup;
+                if ((result = ini_copy_break(&copy)) < 0) goto cleanup;
+                if ((result = ini_copy_blanks(&copy)) < 0) goto cleanup;
+                if ((result = ini_write_value(file_out, copy.p_eol, p_op->p_key, p_op->p_value, NULL)) < 0) goto cleanup;
+                p_op->done = 1;
+                copy.start = off; /* Skip the old line */
+                blank_start = INI_NO_TOKEN;
+                if (!ini_txn_pending(p_txn)) break; /* The rest is copied as is */
+                continue;
+            }
+        }
+        blank_start = INI_NO_TOKEN; /* Copied along with this line */
+    }
+
+    /* End of last section, before its trailing blank lines */
+    if (ini_txn_has_keys(p_txn, section.p_buf)) {
+        if ((result = ini_copy_to(&copy, blank_start != INI_NO_TOKEN ? blank_start : size)) < 0) goto cleanup;
+        if ((result = ini_copy_break(&copy)) < 0) goto cleanup;
+        if ((result = ini_txn_write_keys(p_txn, file_out, copy.p_eol, section.p_buf)) < 0) goto cleanup;
+    }
+    if ((result = ini_copy_to(&copy, size)) < 0) goto cleanup;
+    if ((result = ini_copy_blanks(&copy)) < 0) goto cleanup;
+
+    /* New sections go to the end of the file */
+    for (size_t i = 0; i < p_txn->op_count; ++i) {
+        struct ini_op* p_op = &p_txn->p_ops[i];
+        if (p_op->done || !p_op->p_value) continue;
+        if ((result = ini_copy_break(&copy)) < 0) goto cleanup;
+        if ((result = ini_writef(file_out, copy.p_eol, "%s[%s]", copy.p_eol, p_op->p_section)) < 0) goto cleanup;
+        if ((result = ini_txn_write_keys(p_txn, file_out, copy.p_eol, p_op->p_section)) < 0) goto cleanup;
+    }
+
+cleanup:
+    INI_STAT_ADD(lines_scanned, lines);
+    INI_STAT_ADD(bytes_read, off);
+    (void)lines;
+    ini_line_free(&section);
+    return result < 0 ? result : RET_OK;
+}
+#endif
+
+LIB_EXPORT int
+ini_begin(const char* filename,
+          ini_txn_t** pp_txn)
+{
+    /* Check input pointers */
+    if (!filename || !pp_txn) return RET_NULL;
+    *pp_txn = NULL;
+
+    struct ini_txn* p_txn = calloc(1, sizeof(*p_txn));
+    if (!p_txn) return RET_ERRNO;
+    size_t size = strlen(filename) + 1;
+    p_txn->p_filename = malloc(size);
+    if (!p_txn->p_filename) { free(p_txn); return RET_ERRNO; }
+    memcpy(p_txn->p_filename, filename, size);
+    p_txn->options = atomic_load_explicit(&ini_write_default, memory_order_relaxed);
+
+    *pp_txn = p_txn;
+    return RET_OK;
+}
+
+LIB_EXPORT int
+ini_txn_options(ini_txn_t* p_txn,
+                unsigned options)
+{
+    if (!p_txn) return RET_NULL;
+    p_txn->options = options;
+    return RET_OK;
+}
+
+LIB_EXPORT void
+ini_write_options(unsigned options)
+{
+    atomic_store_explicit(&ini_write_default, options, memory_order_relaxed);
+}
+
+LIB_EXPORT int
+ini_set(ini_txn_t* p_txn,
+        const char* p_section,
+        const char* p_key,
+        const char* p_value,
+        const char* p_comment)
+{
+    if (!p_value) return RET_NULL;
+    return ini_txn_add(p_txn, p_section, p_key, p_value, p_comment);
+}
+
+LIB_EXPORT int
+ini_delete(ini_txn_t* p_txn,
+           const char* p_section,
+           const char* p_key)
+{
+    return ini_txn_add(p_txn, p_section, p_key, NULL, NULL);
+}
+
+LIB_EXPORT void
+ini_abort(ini_txn_t* p_txn)
+{
+    if (!p_txn) return;
+    for (size_t i = 0; i < p_txn->op_count; ++i) free(p_txn->p_ops[i].p_section);
+    free(p_txn->p_ops);
+    free(p_txn->p_filename);
+    free(p_txn);
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+static int
+ini_lock_file(const char* filename,
+              int* p_fd)
+{
+    char lock_name[INI_TMP_NAME_LEN];
+    int result;
+
+    /* A lock file next to the target, the target itself only ever appears through the rename */
+    int len = snprintf(lock_name, sizeof(lock_name), "%s.lock", filename);
+    if (len < 0 || (size_t)len >= sizeof(lock_name)) return RET_BUF;
+    int fd = open(lock_name, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd < 0) return RET_ERRNO;
+
+    /* Writers queue here, the lock is held until the rename */
+    while ((result = flock(fd, LOCK_EX)) != 0 && errno == EINTR);
+    if (result != 0) { result = RET_ERRNO; close(fd); return result; }
+    *p_fd = fd;
+    return RET_OK;
+}
+
+static int
+ini_txn_patch_write(int fd,
+                    const struct ini_op* p_op,
+                    struct ini_line* p_line)
+{
+    /* Updated line with the encoded value padded with spaces, the newline stays as it is */
+    int result = ini_line_reserve(p_line, p_op->line_len + 1);
+    if (result < 0) return result;
+    int len = snprintf(p_line->p_buf, p_line->size, "%s = %s", p_op->p_key, p_op->p_value);
+    memset(p_line->p_buf + len, ' ', p_op->line_len - (size_t)len);
+
+    for (size_t done = 0; done < p_op->line_len; ) {
+        ssize_t n = pwrite(fd, p_line->p_buf + done, p_op->line_len - done, (off_t)(p_op->line_off + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return RET_ERRNO;
+        done += (size_t)n;
+    }
+    INI_STAT_ADD(bytes_written, p_op->line_len);
+    return RET_OK;
+}
+
+static int
+ini_txn_patch(struct ini_txn* p_txn,
+              int fd,
+              const struct stat* p_st)
+{
+    struct ini_line section, line;
+    struct ini_parts parts;
+    struct stat st_out;
+    int result = 0, fd_out = -1;
+    ini_scan_fn scan = ini_scan_select();
+    size_t found = 0, size = (size_t)p_st->st_size;
+
+    /* Only updates qualify, a value with a line break would add lines */
+    for (size_t i = 0; i < p_txn->op_count; ++i) {
+        const char* p_value = p_txn->p_ops[i].p_value;
+        if (!p_value || p_value[strcspn(p_value, "\r\n")] != '\0') return 0;
+    }
+    const char* p_map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p_map == MAP_FAILED) return 0;
+
+    ini_line_init(&section);
+    ini_line_init(&line);
+
+    /* Find the same key lines as the streaming rewrite, each must fit */
+    for (size_t off = 0; off < size && found < p_txn->op_count; ) {
+        const char* p_buf = p_map + off;
+        const char* p_eol = memchr(p_buf, '\n', size - off);
+        size_t len = p_eol ? (size_t)(p_eol - p_buf) : size - off;
+        size_t line_off = off;
+        off += len + 1;
+        if (len > 0 && p_buf[len - 1] == '\r') --len;
+        if (len > INT32_MAX) goto cleanup;
+
+        int kind = ini_classify_line(scan, p_buf, len, &parts);
+        if (kind == INI_KIND_SECTION) {
+            if ((result = ini_line_set(&section, parts.p_name, parts.name_len)) < 0) goto cleanup;
+        }
+        else if (kind == INI_KIND_KEY || kind == INI_KIND_QUOTED) {
+            struct ini_op* p_op = ini_txn_find(p_txn, section.p_buf, parts.p_name, (int)parts.name_len);
+            if (!p_op || p_op->done) continue;
+            if (strlen(p_op->p_key) + 3 + strlen(p_op->p_value) > len) goto cleanup; /* Encoded line must fit */
+            p_op->done = 1;
+            p_op->line_off = (int64_t)line_off;
+            p_op->line_len = len;
+            ++found;
+        }
+    }
+    if (found < p_txn->op_count) goto cleanup;
+
+    /* The locked descriptor is read only, write through a second one */
+    fd_out = open(p_txn->p_filename, O_WRONLY | O_CLOEXEC);
+    if (fd_out < 0 || fstat(fd_out, &st_out) != 0
+        || st_out.st_dev != p_st->st_dev || st_out.st_ino != p_st->st_ino) goto cleanup;
+    for (size_t i = 0; i < p_txn->op_count; ++i) {
+        if ((result = ini_txn_patch_write(fd_out, &p_txn->p_ops[i], &line)) < 0) goto cleanup;
+    }
+    if ((p_txn->options & (INI_WRITE_SYNC_DATA | INI_WRITE_SYNC_DIR)) && fdatasync(fd_out) != 0) {
+        result = RET_ERRNO;
+        goto cleanup;
+    }
+    result = 1;
+
+cleanup:
+    if (result == 0) for (size_t i = 0; i < p_txn->op_count; ++i) p_txn->p_ops[i].done = 0;
+    if (fd_out >= 0 && close(fd_out) != 0 && result > 0) result = RET_ERRNO;
+    munmap((void*)p_map, size);
+    ini_line_free(&section);
+    ini_line_free(&line);
+    return result;
+}
+#endif
+
+static int
+ini_txn_apply(struct ini_txn* p_txn)
+{
+    char temp_name[INI_TMP_NAME_LEN] = "";
+    int result = 0, mode = 0666;
+    FILE* file_out = NULL;
+    FILE* file_in = NULL;
+    const char* filename = p_txn->p_filename;
+
+#if defined(_WIN32) || defined(_WIN64)
+    /* Open actual ini file for reading, a missing file gets a header */
+    file_in = fopen(filename, "r");
+    if (!file_in && errno != ENOENT) return RET_ERRNO;
+    if (file_in) INI_STAT_ADD(files_opened, 1);
+    FILE* file_src = file_in;
+#else
+    struct stat st;
+    struct ini_stamp stamp, current;
+    int fd = -1, lock_fd = -1;
+
+    /* Lock, then remember which version the rewrite is based on */
+    if ((result = ini_lock_file(filename, &lock_fd)) < 0) return result;
+    fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 && errno != ENOENT) { result = RET_ERRNO; goto cleanup; }
+    if (fd >= 0) INI_STAT_ADD(files_opened, 1);
+    if (fstat(fd >= 0 ? fd : lock_fd, &st) != 0) { result = RET_ERRNO; if (fd >= 0) close(fd); goto cleanup; }
+    mode = (int)(st.st_mode & 07777); /* A new file gets the mode the umask gave the lock file */
+    memset(&stamp, 0, sizeof(stamp)); /* Missing, must still be missing at the rename */
+    if (fd >= 0) {
+        ini_stamp_set(&stamp, &st);
+        file_in = fdopen(fd, "r");
+        if (!file_in) { result = RET_ERRNO; close(fd); goto cleanup; }
+    }
+    else st.st_size = 0;
+    FILE* file_src = st.st_size > 0 ? file_in : NULL; /* A missing or empty file gets a header */
+
+    /* Updates that fit their lines are patched in place, no rewrite */
+    if ((p_txn->options & INI_WRITE_INPLACE) && st.st_size > 0) {
+        result = ini_txn_patch(p_txn, fd, &st);
+        if (result > 0) { result = RET_OK; ini_cache_drop(filename); goto cleanup; }
+        if (result < 0) goto cleanup;
+    }
+#endif
+
+    /* Temporary file next to the target */
+    if ((result = ini_temp_open(filename, mode, temp_name, sizeof(temp_name), &file_out)) < 0) goto cleanup;
+    if (!file_src && (result = ini_write_header(file_out)) < 0) goto cleanup;
+
+#if defined(_WIN32) || defined(_WIN64)
+    /* Single streaming rewrite */
+    if ((result = ini_txn_write(p_txn, file_src, file_out)) < 0) goto cleanup;
+    INI_STAT_ADD(bytes_written, ftell(file_out));
+#else
+    /* Unchanged ranges of a mapped source are copied, only changed lines are formatted */
+    const char* p_map = file_src ? mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (p_map != MAP_FAILED) {
+        result = ini_txn_write_mem(p_txn, fd, p_map, (size_t)st.st_size, file_out);
+        munmap((void*)p_map, (size_t)st.st_size);
+        if (result < 0) goto cleanup;
+        INI_STAT_ADD(bytes_written, fflush(file_out) == 0 ? lseek(fileno(file_out), 0, SEEK_CUR) : 0); /* ftell() misses copies */
+    }
+    else {
+        if ((result = ini_txn_write(p_txn, file_src, file_out)) < 0) goto cleanup;
+        INI_STAT_ADD(bytes_written, ftell(file_out));
+    }
+#endif
+    if ((p_txn->options & (INI_WRITE_SYNC_DATA | INI_WRITE_SYNC_DIR))
+        && (result = ini_sync_file(file_out)) < 0) goto cleanup;
+
+#if defined(_WIN32) || defined(_WIN64)
+    if (file_in) { fclose(file_in); file_in = NULL; } /* Open files can not be replaced */
+#else
+    /* Writers that do not lock are detected by the changed stamp, the caller retries */
+    memset(&current, 0, sizeof(current));
+    if (stat(filename, &st) == 0) ini_stamp_set(&current, &st);
+    else if (errno != ENOENT) { result = RET_CHANGED; goto cleanup; }
+    if (!ini_stamp_equal(&stamp, &current)) { result = RET_CHANGED; goto cleanup; }
+#if defined(O_TMPFILE)
+    if (!temp_name[0] && (result = ini_temp_link(file_out, filename, temp_name, sizeof(temp_name))) < 0) goto cleanup;
+#endif
+#endif
+    result = fclose(file_out) == 0 ? RET_OK : RET_ERRNO;
+    file_out = NULL;
+    if (result < 0) goto cleanup;
+
+    /* One atomic rename */
+    if ((result = ini_replace_file(temp_name, filename, p_txn->options)) < 0) goto cleanup;
+    temp_name[0] = '\0';
+    INI_STAT_ADD(renames, 1);
+#if !defined(_WIN32) && !defined(_WIN64)
+    ini_cache_drop(filename);
+    if (p_txn->options & INI_WRITE_SYNC_DIR) result = ini_sync_dir(filename);
+#endif
+
+cleanup:
+    if (file_out) fclose(file_out); /* An unnamed temporary file disappears here */
+    if (result < 0 && temp_name[0]) remove(temp_name);
+    if (file_in) fclose(file_in);
+#if !defined(_WIN32) && !defined(_WIN64)
+    if (lock_fd >= 0) close(lock_fd); /* Releases the lock */
+#endif
+    return result;
+}
+
+static int
+ini_txn_commit(struct ini_txn* p_txn)
+{
+    int result = RET_CHANGED;
+
+    /* Reapply all operations on top of the changed file */
+    for (int i = 0; i < INI_WRITE_RETRIES && result == RET_CHANGED; ++i) {
+        for (size_t i_op = 0; i_op < p_txn->op_count; ++i_op) p_txn->p_ops[i_op].done = 0;
+        result = ini_txn_apply(p_txn);
+    }
+    return result;
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+/* Queued write-behind update */
+struct ini_behind_op {
+    struct ini_behind_op* p_next;
+    char* p_filename;   /* Strings follow the node in one allocation */
+    char* p_section;
+    char* p_key;
+    char* p_value;
+    char* p_comment;    /* Comment for new keys or NULL */
+};
+
+/* Write-behind state, producers only touch the atomics */
+static struct {
+    _Atomic(struct ini_behind_op*) p_top; /* Lock-free stack of queued updates */
+    atomic_size_t pending;      /* Updates queued and not yet committed */
+    atomic_int active;
+    pthread_mutex_t lock;       /* Everything below */
+    pthread_cond_t wake;        /* Writer thread, on CLOCK_MONOTONIC */
+    pthread_cond_t done;        /* End of a flush cycle */
+    pthread_t thread;
+    unsigned interval_ms;
+    atomic_size_t batch_size;   /* Read without the lock by producers */
+    struct ini_txn** p_files;   /* Drained updates, one coalescing transaction per file */
+    size_t file_count;
+    size_t file_size;
+    size_t drained;             /* Updates in p_files */
+    struct ini_txn** p_flushing;/* Being committed, still visible to readers */
+    size_t flushing_count;
+    uint64_t cycle_started;
+    atomic_ullong cycle_done;   /* Read without the lock by readers */
+    int busy;                   /* A cycle is committing */
+    int flush;                  /* ini_flush() is waiting */
+    int stop;
+    int error;                  /* First failure since the last ini_flush() */
+} ini_behind = { .lock = PTHREAD_MUTEX_INITIALIZER, .done = PTHREAD_COND_INITIALIZER };
+
+static pthread_once_t ini_behind_once = PTHREAD_ONCE_INIT;
+
+static void
+ini_behind_init(void)
+{
+    /* Never destroyed, producers may still signal it while the writer stops */
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&ini_behind.wake, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static struct ini_txn*
+ini_behind_find(struct ini_txn** p_txns,
+                size_t count,
+                const char* filename)
+{
+    for (size_t i = 0; i < count; ++i) {
+        if (strcmp(p_txns[i]->p_filename, filename) == 0) return p_txns[i];
+    }
+    return NULL;
+}
+
+static int
+ini_behind_add(const struct ini_behind_op* p_op)
+{
+    /* Same path string, same file */
+    struct ini_txn* p_txn = ini_behind_find(ini_behind.p_files, ini_behind.file_count, p_op->p_filename);
+    if (!p_txn) {
+        if (ini_behind.file_count == ini_behind.file_size) {
+            size_t size = ini_behind.file_size ? ini_behind.file_size * 2 : 4;
+            struct ini_txn** p_files = realloc(ini_behind.p_files, size * sizeof(*p_files));
+            if (!p_files) return RET_ERRNO;
+            ini_behind.p_files = p_files;
+            ini_behind.file_size = size;
+        }
+        int result = ini_begin(p_op->p_filename, &p_txn);
+        if (result < 0) return result;
+        ini_behind.p_files[ini_behind.file_count++] = p_txn;
+    }
+    return ini_txn_add(p_txn, p_op->p_section, p_op->p_key, p_op->p_value, p_op->p_comment);
+}
+
+static void
+ini_behind_drain(void)
+{
+    /* Take the whole stack and restore queue order, the last update of a key wins */
+    struct ini_behind_op* p_op = atomic_exchange(&ini_behind.p_top, NULL);
+    struct ini_behind_op* p_fifo = NULL;
+    while (p_op) {
+        struct ini_behind_op* p_next = p_op->p_next;
+        p_op->p_next = p_fifo;
+        p_fifo = p_op;
+        p_op = p_next;
+    }
+    while (p_fifo) {
+        struct ini_behind_op* p_next = p_fifo->p_next;
+        int result = ini_behind_add(p_fifo);
+        if (result < 0 && !ini_behind.error) ini_behind.error = result;
+        free(p_fifo);
+        ini_behind.drained++;
+        p_fifo = p_next;
+    }
+}
+
+static void
+ini_behind_cycle(void)
+{
+    /* Called with the lock held, one cycle commits at a time to keep update order */
+    while (ini_behind.busy) pthread_cond_wait(&ini_behind.done, &ini_behind.lock);
+    uint64_t cycle = ++ini_behind.cycle_started;
+    ini_behind.busy = 1;
+    ini_behind_drain();
+    struct ini_txn** p_txns = ini_behind.p_files;
+    size_t count = ini_behind.file_count, drained = ini_behind.drained;
+    ini_behind.p_files = NULL;
+    ini_behind.file_count = ini_behind.file_size = ini_behind.drained = 0;
+    ini_behind.p_flushing = p_txns;
+    ini_behind.flushing_count = count;
+
+    /* Commit outside the lock, readers still see the values */
+    int error = RET_OK;
+    pthread_mutex_unlock(&ini_behind.lock);
+    for (size_t i = 0; i < count; ++i) {
+        int result = ini_txn_commit(p_txns[i]);
+        if (result < 0 && error == RET_OK) error = result;
+    }
+    pthread_mutex_lock(&ini_behind.lock);
+
+    ini_behind.p_flushing = NULL;
+    ini_behind.flushing_count = 0;
+    for (size_t i = 0; i < count; ++i) ini_abort(p_txns[i]);
+    free(p_txns);
+    if (error < 0 && !ini_behind.error) ini_behind.error = error;
+    atomic_fetch_sub(&ini_behind.pending, drained);
+    ini_behind.cycle_done = cycle;
+    ini_behind.busy = 0;
+    pthread_cond_broadcast(&ini_behind.done);
+}
+
+static void*
+ini_behind_thread(void* p_arg)
+{
+    (void)p_arg;
+    pthread_mutex_lock(&ini_behind.lock);
+    while (!ini_behind.stop) {
+        /* Sleep for the interval unless a batch fills up or a flush is requested */
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += ini_behind.interval_ms / 1000;
+        deadline.tv_nsec += (long)(ini_behind.interval_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) { deadline.tv_sec++; deadline.tv_nsec -= 1000000000; }
+        while (!ini_behind.stop && !ini_behind.flush
+               && atomic_load(&ini_behind.pending) < atomic_load(&ini_behind.batch_size)
+               && pthread_cond_timedwait(&ini_behind.wake, &ini_behind.lock, &deadline) == 0);
+        ini_behind.flush = 0;
+        /* Idle ticks start no cycle, readers stay on the lock-free path */
+        if (atomic_load(&ini_behind.pending) > 0) ini_behind_cycle();
+        pthread_cond_broadcast(&ini_behind.done);
+    }
+    pthread_mutex_unlock(&ini_behind.lock);
+    return NULL;
+}
+
+static int
+ini_behind_push(const char* filename,
+                const char* p_section,
+                const char* p_key,
+                const char* p_value,
+                const char* p_comment)
+{
+    /* One allocation holds the node and all strings */
+    size_t filename_size = strlen(filename) + 1, section_size = strlen(p_section) + 1;
+    size_t key_size = strlen(p_key) + 1, value_size = strlen(p_value) + 1;
+    size_t comment_size = p_comment ? strlen(p_comment) + 1 : 0;
+    struct ini_behind_op* p_op = malloc(sizeof(*p_op) + filename_size + section_size + key_size + value_size + comment_size);
+    if (!p_op) return RET_ERRNO;
+    char* p_mem = (char*)(p_op + 1);
+    p_op->p_filename = memcpy(p_mem, filename, filename_size);
+    p_op->p_section = memcpy(p_mem += filename_size, p_section, section_size);
+    p_op->p_key = memcpy(p_mem += section_size, p_key, key_size);
+    p_op->p_value = memcpy(p_mem += key_size, p_value, value_size);
+    p_op->p_comment = p_comment ? memcpy(p_mem + value_size, p_comment, comment_size) : NULL;
+
+    /* Counted before it is visible, readers never miss a queued update */
+    size_t pending = atomic_fetch_add(&ini_behind.pending, 1) + 1;
+    p_op->p_next = atomic_load_explicit(&ini_behind.p_top, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak(&ini_behind.p_top, &p_op->p_next, p_op));
+
+    /* Stopped meanwhile, nobody else will drain it */
+    if (!atomic_load(&ini_behind.active)) {
+        pthread_mutex_lock(&ini_behind.lock);
+        if (atomic_load(&ini_behind.pending) > 0) ini_behind_cycle();
+        int result = ini_behind.error;
+        ini_behind.error = RET_OK;
+        pthread_mutex_unlock(&ini_behind.lock);
+        return result;
+    }
+    if (pending >= atomic_load_explicit(&ini_behind.batch_size, memory_order_relaxed)) pthread_cond_signal(&ini_behind.wake);
+    return RET_OK;
+}
+
+static int
+ini_behind_value(const char* p_raw,
+                 char* p_value,
+                 size_t value_size)
+{
+    /* The value a parse of the written "key = value" line returns */
+    while (ISSPACE(*p_raw)) ++p_raw;
+    size_t len = strlen(p_raw);
+    if (*p_raw == '"') return ini_parse_value(p_raw, len, p_value, value_size);
+    for (size_t i = 0; i < len; ++i) if (ISCOMMENT(p_raw[i])) { len = i; break; }
+    while (len > 0 && ISSPACE(p_raw[len - 1])) --len;
+    if (len > value_size - 1) len = value_size - 1;
+    memcpy(p_value, p_raw, len);
+    p_value[len] = '\0';
+    return (int)len;
+}
+
+static uint64_t
+ini_behind_cycles(void)
+{
+    return atomic_load(&ini_behind.cycle_done);
+}
+
+static int
+ini_behind_read(const char* filename,
+                ini_query_t* p_query,
+                size_t count,
+                int found,
+                uint64_t cycle)
+{
+    /* Nothing queued and nothing committed since the file was read */
+    if (atomic_load(&ini_behind.pending) == 0 && ini_behind_cycles() == cycle) return found;
+
+    pthread_mutex_lock(&ini_behind.lock);
+    /* A cycle finished after the read, its values may be in neither. No
+     * cycle can finish while the lock is held, so a second read is current */
+    if (ini_behind_cycles() != cycle) found = ini_cache_query(filename, p_query, count);
+    ini_behind_drain();
+    struct ini_txn* p_txns[2] = {
+        ini_behind_find(ini_behind.p_files, ini_behind.file_count, filename),
+        ini_behind_find(ini_behind.p_flushing, ini_behind.flushing_count, filename),
+    };
+    if ((p_txns[0] || p_txns[1]) && found < 0) { /* Not written yet, start from an empty file */
+        for (size_t i = 0; i < count; ++i) {
+            if (p_query[i].p_value && p_query[i].value_size > 0) p_query[i].p_value[0] = '\0';
+            p_query[i].result = RET_EOF;
+        }
+    }
+
+    /* Queued values win over flushing ones, both over the file */
+    int overlaid = 0;
+    for (size_t i = 0; i < count; ++i) {
+        ini_query_t* p_entry = &p_query[i];
+        if (!p_entry->p_section || !p_entry->p_key || !p_entry->p_value || p_entry->value_size == 0) continue;
+        for (int t = 0; t < 2; ++t) {
+            struct ini_op* p_op = p_txns[t] ? ini_txn_find(p_txns[t], p_entry->p_section, p_entry->p_key, (int)strlen(p_entry->p_key)) : NULL;
+            if (!p_op || !p_op->p_value) continue;
+            if (p_entry->result < 0) ++overlaid;
+            p_entry->result = ini_behind_value(p_op->p_value, p_entry->p_value, p_entry->value_size);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&ini_behind.lock);
+    if (found < 0) return overlaid > 0 ? overlaid : found;
+    return found + overlaid;
+}
+
+static void
+ini_behind_wait(void)
+{
+    /* A cycle that starts after this call commits everything queued before it */
+    if (atomic_load(&ini_behind.pending) == 0) return;
+    pthread_mutex_lock(&ini_behind.lock);
+    if (atomic_load(&ini_behind.pending) > 0) {
+        uint64_t cycle = ini_behind.cycle_started + 1;
+        if (atomic_load(&ini_behind.active)) {
+            ini_behind.flush = 1;
+            pthread_cond_signal(&ini_behind.wake);
+            /* All committed also ends the wait, idle ticks start no cycle */
+            while (ini_behind.cycle_done < cycle && atomic_load(&ini_behind.pending) > 0 && atomic_load(&ini_behind.active)) {
+                pthread_cond_wait(&ini_behind.done, &ini_behind.lock);
+            }
+        }
+        if (ini_behind.cycle_done < cycle && atomic_load(&ini_behind.pending) > 0) ini_behind_cycle(); /* Stopped meanwhile */
+    }
+    pthread_mutex_unlock(&ini_behind.lock);
+}
+#endif
+
+LIB_EXPORT int
+ini_commit(ini_txn_t* p_txn)
+{
+    /* Check input pointers */
+    if (!p_txn) return RET_NULL;
+
+    INI_STAT_START(start);
+#if !defined(_WIN32) && !defined(_WIN64)
+    ini_behind_wait(); /* Queued writes were made first */
+#endif
+    int result = ini_txn_commit(p_txn);
+    ini_abort(p_txn);
+    INI_STAT_TIME(commit, start);
+    return result;
+}
+
+LIB_EXPORT int
+ini_write_key(const char* filename, 
+              const char* p_section, 
+              const char* p_key, 
+              const char* p_value, 
+              const char* p_comment)
+{
+    ini_txn_t* p_txn = NULL;
+
+    /* Check input pointers */
+    if (!filename || !p_section || !p_key || !p_value) return RET_NULL;
+
+#if !defined(_WIN32) && !defined(_WIN64)
+    if (atomic_load(&ini_behind.active)) return ini_behind_push(filename, p_section, p_key, p_value, p_comment);
+#endif
+
+    /* Single operation transaction */
+    int result = ini_begin(filename, &p_txn);
+    if (result < 0) return result;
+    result = ini_set(p_txn, p_section, p_key, p_value, p_comment);
+    if (result < 0) { ini_abort(p_txn); return result; }
+    return ini_commit(p_txn);
+}
+
+LIB_EXPORT int
+ini_write_behind(unsigned interval_ms,
+                 size_t batch_size)
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+    int result = RET_OK;
+    pthread_once(&ini_behind_once, ini_behind_init);
+    pthread_mutex_lock(&ini_behind.lock);
+    if (atomic_load(&ini_behind.active)) {
+        /* Stop, new writes are synchronous again, then commit what is left */
+        atomic_store(&ini_behind.active, 0);
+        ini_behind.stop = 1;
+        pthread_cond_signal(&ini_behind.wake);
+        pthread_mutex_unlock(&ini_behind.lock);
+        pthread_join(ini_behind.thread, NULL);
+        pthread_mutex_lock(&ini_behind.lock);
+        if (atomic_load(&ini_behind.pending) > 0) ini_behind_cycle();
+        pthread_cond_broadcast(&ini_behind.done);
+        result = ini_behind.error;
+        ini_behind.error = RET_OK;
+    }
+    if (interval_ms > 0 && result == RET_OK) {
+        ini_behind.interval_ms = interval_ms;
+        atomic_store(&ini_behind.batch_size, batch_size ? batch_size : SIZE_MAX);
+        ini_behind.stop = 0;
+        if ((result = pthread_create(&ini_behind.thread, NULL, ini_behind_thread, NULL)) != 0) result = RET_ERRVAL(result);
+        else atomic_store(&ini_behind.active, 1);
+    }
+    pthread_mutex_unlock(&ini_behind.lock);
+    return result;
+#else
+    (void)interval_ms; (void)batch_size;
+    return RET_NOSUP;
+#endif
+}
+
+LIB_EXPORT int
+ini_flush(void)
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+    ini_behind_wait();
+    pthread_mutex_lock(&ini_behind.lock);
+    int result = ini_behind.error;
+    ini_behind.error = RET_OK;
+    pthread_mutex_unlock(&ini_behind.lock);
+    return result;
+#else
+    return RET_OK;
+#endif
+}
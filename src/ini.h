@@ -7,7 +7,13 @@
  ****************************************************************************/
 /**
  * @brief     INI-Reader/Writer
- * @details
+ * @details   Thread safety: every function is reentrant and keeps its
+ *            state in the caller's buffers or handles. An opened ini_doc_t
+ *            is immutable and may be read from any number of threads; a
+ *            transaction belongs to the thread that began it. The parse
+ *            cache and watchers synchronise internally, and
+ *            ini_error_string() formats errno text into a per-thread
+ *            buffer.
  *
  * @pre       
  * @bug       
@@ -20,10 +26,12 @@
 #ifdef __cplusplus    /* C++ compability */
 #  include <cstdint>
 #  include <cstddef>
+#  include <cstdio>
 extern "C" {
 #else
 #  include <stdint.h>
 #  include <stddef.h>
+#  include <stdio.h>
 #endif
 
 /*
@@ -61,6 +69,26 @@ ini_read_key(const char* filename,
              char* p_value,
              size_t value_size);
 
+/**
+ * @brief      Read a key from INI text held in memory
+ * @param      p_buf       INI text, need not be null terminated
+ * @param      size        Length of p_buf in bytes
+ * @param      p_section   Section name (case-insensitive)
+ * @param      p_key       Key name (case-insensitive)
+ * @param      p_value     Destination buffer, always null terminated
+ * @param      value_size  Size of destination buffer
+ * @return     Length of the copied value, or negative error code.
+ * @details    Same result as ini_read_key() on a file with this content.
+ *             Scans once without building a document or allocating.
+ */
+LIB_EXPORT int
+ini_read_key_mem(const char* p_buf,
+                 size_t size,
+                 const char* p_section,
+                 const char* p_key,
+                 char* p_value,
+                 size_t value_size);
+
 LIB_EXPORT int
 ini_write_key(const char* filename, 
               const char* p_section, 
@@ -68,6 +96,713 @@ ini_write_key(const char* filename,
               const char* p_value, 
               const char* p_comment);
 
+/**
+ * @brief      Parse cache counters from ini_cache_stats()
+ */
+typedef struct ini_cache_stats {
+    uint64_t hits;          /**< Reads served from the cache */
+    uint64_t misses;        /**< Reads that parsed the file */
+    uint64_t evictions;     /**< Documents dropped to stay below the limit */
+    size_t entries;         /**< Cached documents */
+    size_t mem_size;        /**< Memory used by cached documents in bytes */
+    size_t limit;           /**< Memory limit in bytes */
+} ini_cache_stats_t;
+
+/**
+ * @brief      Drop all cached documents
+ * @details    ini_read_key() and ini_read_keys() keep parsed documents in
+ *             a process-wide cache keyed by path. A cached document is
+ *             used while device, inode, size and modification time of the
+ *             file are unchanged, so each read costs one stat(). A file
+ *             rewritten in place with the same size within the timestamp
+ *             resolution of its file system is not detected, flush the
+ *             cache in that case. Not available on Windows.
+ */
+LIB_EXPORT void
+ini_cache_flush(void);
+
+/**
+ * @brief      Set the memory limit of the parse cache
+ * @param      limit  Limit in bytes, 0 disables caching. Default 16 MB.
+ */
+LIB_EXPORT void
+ini_cache_limit(size_t limit);
+
+/**
+ * @brief      Get parse cache counters
+ * @param      p_stats  Receives the counters
+ */
+LIB_EXPORT void
+ini_cache_stats(ini_cache_stats_t* p_stats);
+
+#define INI_STATS_BUCKETS (32)   /**< Log2 nanosecond latency buckets */
+
+/**
+ * @brief      Latency histogram, bucket i counts calls of 2^i to 2^(i+1) ns
+ */
+typedef struct ini_latency {
+    uint64_t count;         /**< Timed calls */
+    uint64_t total_ns;      /**< Sum of all latencies */
+    uint64_t buckets[INI_STATS_BUCKETS];
+} ini_latency_t;
+
+/**
+ * @brief      Hot-path counters from ini_stats_get()
+ */
+typedef struct ini_stats {
+    uint64_t files_opened;  /**< Files opened for reading or writing */
+    uint64_t lines_scanned; /**< Lines tokenized by parses and rewrites */
+    uint64_t bytes_read;    /**< Bytes tokenized by parses and rewrites */
+    uint64_t bytes_written; /**< Bytes written by rewrites and in-place patches */
+    uint64_t temp_files;    /**< Temporary files created */
+    uint64_t renames;       /**< Temporary files renamed over the target */
+    uint64_t cache_hits;    /**< Reads served from the parse cache */
+    uint64_t cache_misses;  /**< Reads that parsed the file */
+    ini_latency_t read_key; /**< ini_read_key() and ini_read_keys() */
+    ini_latency_t open;     /**< ini_open() */
+    ini_latency_t get;      /**< ini_get() */
+    ini_latency_t commit;   /**< ini_commit() and the ini_write_key() family */
+} ini_stats_t;
+
+/**
+ * @brief      Get instrumentation counters
+ * @details    Counting is compiled in only with -DINI_STATS, otherwise the
+ *             hot paths carry no instrumentation at all. Counters are
+ *             process-wide relaxed atomics; a snapshot taken while other
+ *             threads work is not consistent across fields.
+ * @param      p_stats  Receives the counters
+ * @return     0 on success, RET_NOSUP (-13) when built without INI_STATS
+ */
+LIB_EXPORT int
+ini_stats_get(ini_stats_t* p_stats);
+
+/**
+ * @brief      Reset instrumentation counters to zero
+ */
+LIB_EXPORT void
+ini_stats_reset(void);
+
+/**
+ * @brief      Write transaction handle
+ * @details    Collects set and delete operations that are applied with a
+ *             single streaming rewrite and one atomic rename. The
+ *             temporary file is created next to the target, unnamed with
+ *             O_TMPFILE where the file system supports it, so the rename
+ *             never crosses file systems and nothing is left behind.
+ */
+typedef struct ini_txn ini_txn_t;
+
+/**
+ * @brief      Start a write transaction on an INI file
+ * @param      filename  Path to the INI file, created on commit if missing
+ * @param      pp_txn    Receives the transaction handle on success
+ * @return     0 on success, negative error code on failure.
+ * @details    Finish with ini_commit() or ini_abort().
+ */
+LIB_EXPORT int
+ini_begin(const char* filename,
+          ini_txn_t** pp_txn);
+
+/**
+ * @brief      Set a key in a transaction
+ * @param      p_txn      Transaction from ini_begin()
+ * @param      p_section  Section name (case-insensitive)
+ * @param      p_key      Key name (case-insensitive)
+ * @param      p_value    Value, quoted and escaped if needed
+ * @param      p_comment  Comment written above new keys, or NULL
+ * @return     0 on success, negative error code on failure.
+ * @details    A later set or delete of the same key replaces this one.
+ *             New keys go at the end of their section and new sections
+ *             at the end of the file.
+ *             Values that contain '#', ';', control characters or leading
+ *             or trailing whitespace are written in quotes with escapes, so
+ *             they read back unchanged. Values starting with '"' are taken
+ *             as already quoted and written as they are, unless they hold
+ *             a line break; those are quoted and escaped like any other.
+ */
+LIB_EXPORT int
+ini_set(ini_txn_t* p_txn,
+        const char* p_section,
+        const char* p_key,
+        const char* p_value,
+        const char* p_comment);
+
+/**
+ * @brief      Delete a key in a transaction
+ * @param      p_txn      Transaction from ini_begin()
+ * @param      p_section  Section name (case-insensitive)
+ * @param      p_key      Key name (case-insensitive)
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+ini_delete(ini_txn_t* p_txn,
+           const char* p_section,
+           const char* p_key);
+
+/**
+ * @brief      Apply all operations and release the transaction
+ * @param      p_txn  Transaction from ini_begin()
+ * @return     0 on success, negative error code on failure.
+ * @details    The file is left unchanged on failure. The handle is
+ *             released in both cases. On POSIX systems concurrent commits
+ *             to the same file, from any process, are serialised with an
+ *             advisory flock() on "<file>.lock", which is left in place.
+ *             The file itself is only replaced by the rename, a missing
+ *             file never appears empty. A file changed by a writer
+ *             that does not lock is detected before the rename and the
+ *             operations are applied again to its new content. Unchanged
+ *             lines are copied as they are and new or updated lines end
+ *             like the first line of the file, LF or CRLF.
+ */
+LIB_EXPORT int
+ini_commit(ini_txn_t* p_txn);
+
+/**
+ * @brief      Release a transaction without applying it
+ * @param      p_txn  Transaction handle, NULL is ignored
+ */
+LIB_EXPORT void
+ini_abort(ini_txn_t* p_txn);
+
+#define INI_WRITE_INPLACE   (1u << 0) /**< Patch same-length updates in place */
+#define INI_WRITE_SYNC_DATA (1u << 1) /**< fdatasync() the new content before it replaces the file */
+#define INI_WRITE_SYNC_DIR  (1u << 2) /**< SYNC_DATA and fsync() the directory after the rename */
+
+/**
+ * @brief      Set the write options of a transaction
+ * @param      p_txn    Transaction from ini_begin()
+ * @param      options  INI_WRITE_* flags, replace the defaults
+ * @return     0 on success, negative error code on failure.
+ * @details    With INI_WRITE_INPLACE a commit that only updates existing
+ *             keys, each new "key = value" line no longer than the line
+ *             it replaces, overwrites just those lines with pwrite() and
+ *             pads them with spaces. Lengths are those of the values as
+ *             written, after quoting and escaping; a value that still holds
+ *             a line break falls back. This skips the temporary copy and
+ *             rename but is not atomic: a reader can see a half written
+ *             line and a failed write can leave some lines updated. Any
+ *             other commit falls back to the full rewrite. Ignored on
+ *             Windows.
+ *
+ *             Without a sync flag a commit is atomic but may be lost on a
+ *             crash or power failure. INI_WRITE_SYNC_DATA flushes the new
+ *             content to disk before the rename; INI_WRITE_SYNC_DIR also
+ *             flushes the directory entry, so a successful commit survives
+ *             a crash. Each level adds one or more disk flushes of latency.
+ */
+LIB_EXPORT int
+ini_txn_options(ini_txn_t* p_txn,
+                unsigned options);
+
+/**
+ * @brief      Set the default write options of new transactions
+ * @param      options  INI_WRITE_* flags, also used by ini_write_key()
+ */
+LIB_EXPORT void
+ini_write_options(unsigned options);
+
+/**
+ * @brief      Start, reconfigure or stop the write-behind writer
+ * @param      interval_ms  Commit interval, 0 stops the writer
+ * @param      batch_size   Queued updates that trigger an early commit,
+ *                          0 for the interval only
+ * @return     0 on success, negative error code on failure. Stopping
+ *             commits all queued updates and returns the first error.
+ * @details    While running, ini_write_key() only queues the update on a
+ *             lock-free queue and returns. A background thread coalesces
+ *             the queue per file and per key, so each file is rewritten
+ *             once per interval with the last value of every key. Errors
+ *             of these commits are reported by ini_flush(). Files are told
+ *             apart by their path string.
+ *
+ *             ini_read_key() and ini_read_keys() in the same process see
+ *             queued values before they reach the file. Documents from
+ *             ini_open() and ini_get_section() show the file itself.
+ *             ini_commit() first waits for all queued updates, so writes
+ *             keep their program order. Not available on Windows.
+ */
+LIB_EXPORT int
+ini_write_behind(unsigned interval_ms,
+                 size_t batch_size);
+
+/**
+ * @brief      Wait until all queued write-behind updates are committed
+ * @return     0 on success, first commit error since the last call.
+ * @details    Covers every ini_write_key() that returned before the call.
+ *             Returns at once when the writer is not running.
+ */
+LIB_EXPORT int
+ini_flush(void);
+
+/**
+ * @brief      Parsed INI document handle
+ * @details    Holds all section/key/value triplets of one INI file parsed
+ *             into memory with a case-insensitive hash index.
+ */
+typedef struct ini_doc ini_doc_t;
+
+/**
+ * @brief      Parse an INI file once into an in-memory document
+ * @param      filename  Path to the INI file
+ * @param      pp_doc    Receives the document handle on success
+ * @return     0 on success, negative error code on failure.
+ * @details    Release the document with ini_close(). When a compiled
+ *             image filename.bin exists and matches the file, it is mapped
+ *             instead of parsing the text, see ini_compile().
+ */
+LIB_EXPORT int
+ini_open(const char* filename,
+         ini_doc_t** pp_doc);
+
+/**
+ * @brief      Set the number of threads parsing one large file
+ * @param      threads  Thread limit, 0 for one per online CPU (default),
+ *                      1 to always parse on the calling thread
+ * @details    Mapped files of at least 2 MB are cut at section headers
+ *             into up to this many chunks of 1 MB or more. The chunks
+ *             are tokenized in parallel and merged in file order, so the
+ *             document is the same as from a single-threaded parse.
+ *             Applies to ini_open() and the parse cache. Not available
+ *             on Windows.
+ */
+LIB_EXPORT void
+ini_parse_threads(unsigned threads);
+
+/**
+ * @brief      Parse INI text held in memory into a document
+ * @param      p_buf   INI text, need not be null terminated
+ * @param      size    Length of p_buf in bytes
+ * @param      pp_doc  Receives the document handle on success
+ * @return     0 on success, negative error code on failure.
+ * @details    The document keeps its own copy, p_buf may be released
+ *             right after. Release the document with ini_close().
+ */
+LIB_EXPORT int
+ini_open_mem(const char* p_buf,
+             size_t size,
+             ini_doc_t** pp_doc);
+
+/**
+ * @brief      Compile an INI file into a binary image
+ * @param      filename      Path to the INI file
+ * @param      p_image_name  Image path, NULL for filename.bin
+ * @return     0 on success, negative error code on failure.
+ * @details    The image holds a perfect hash index and a string pool and
+ *             is loaded by ini_open() with a single mmap. ini_open() only
+ *             looks for filename.bin; an image written elsewhere is for
+ *             staging and must be renamed to filename.bin to be used. It
+ *             records the device, inode, size and mtime of the source and
+ *             is ignored once the source changes, so it is only ever an
+ *             accelerator. Images
+ *             are native byte order and not portable between hosts.
+ *             POSIX only.
+ */
+LIB_EXPORT int
+ini_compile(const char* filename,
+            const char* p_image_name);
+
+/**
+ * @brief      Look up a key in a parsed document
+ * @param      p_doc       Document from ini_open()
+ * @param      p_section   Section name (case-insensitive)
+ * @param      p_key       Key name (case-insensitive)
+ * @param      p_value     Destination buffer, always null terminated
+ * @param      value_size  Size of destination buffer
+ * @return     Length of the copied value, or negative error code.
+ * @details    No file I/O is done. Same result as ini_read_key().
+ */
+LIB_EXPORT int
+ini_get(const ini_doc_t* p_doc,
+        const char* p_section,
+        const char* p_key,
+        char* p_value,
+        size_t value_size);
+
+/**
+ * @brief      One key lookup for ini_read_keys() and ini_get_keys()
+ */
+typedef struct ini_query {
+    const char* p_section;  /**< Section name (case-insensitive) */
+    const char* p_key;      /**< Key name (case-insensitive) */
+    char* p_value;          /**< Destination buffer, always null terminated */
+    size_t value_size;      /**< Size of destination buffer */
+    int result;             /**< Out: value length or negative error code */
+} ini_query_t;
+
+/**
+ * @brief      Look up several keys in a parsed document
+ * @param      p_doc     Document from ini_open()
+ * @param      p_query   Array of lookups, result is set for each entry
+ * @param      count     Number of entries in p_query
+ * @return     Number of keys found, or negative error code.
+ */
+LIB_EXPORT int
+ini_get_keys(const ini_doc_t* p_doc,
+             ini_query_t* p_query,
+             size_t count);
+
+/**
+ * @brief      Case-insensitive hash of a section/key pair
+ * @param      p_section  Section name
+ * @param      p_key      Key name
+ * @return     FNV-1a 64 bit hash of the ASCII lowercased names, with a
+ *             zero byte between section and key.
+ * @details    Same value as settings::key_hash() in ini.hpp, which
+ *             computes it at compile time.
+ */
+LIB_EXPORT uint64_t
+ini_key_hash(const char* p_section,
+             const char* p_key);
+
+/**
+ * @brief      Look up a key without copying the value
+ * @param      p_doc      Document from ini_open()
+ * @param      p_section  Section name (case-insensitive)
+ * @param      p_key      Key name (case-insensitive)
+ * @param      pp_value   Receives a pointer into the document
+ * @param      p_len      Receives the value length
+ * @return     0 on success, negative error code on failure.
+ * @details    The value is null terminated and valid until ini_close().
+ */
+LIB_EXPORT int
+ini_get_view(const ini_doc_t* p_doc,
+             const char* p_section,
+             const char* p_key,
+             const char** pp_value,
+             size_t* p_len);
+
+/**
+ * @brief      Look up a key by a precomputed ini_key_hash()
+ * @param      p_doc     Document from ini_open()
+ * @param      hash      Hash of section and key
+ * @param      pp_value  Receives a pointer into the document
+ * @param      p_len     Receives the value length
+ * @return     0 on success, negative error code on failure.
+ * @details    Names are not compared, the first key with the hash is
+ *             returned. Distinct names sharing a 64 bit hash are not
+ *             told apart; use ini_get_view() when that matters.
+ */
+LIB_EXPORT int
+ini_get_view_hash(const ini_doc_t* p_doc,
+                  uint64_t hash,
+                  const char** pp_value,
+                  size_t* p_len);
+
+/**
+ * @brief      Read an integer value from a parsed document
+ * @param      p_doc      Document from ini_open()
+ * @param      p_section  Section name (case-insensitive)
+ * @param      p_key      Key name (case-insensitive)
+ * @param      p_value    Receives the value, unchanged on failure
+ * @return     0 on success, negative error code on failure.
+ * @details    Decimal or 0x hexadecimal with an optional binary size
+ *             suffix k, m, g or t (64k = 65536). Parsing is independent of
+ *             the C locale. The first typed read of a key caches the
+ *             converted value in the document, later reads only look it up.
+ */
+LIB_EXPORT int
+ini_get_int(const ini_doc_t* p_doc,
+            const char* p_section,
+            const char* p_key,
+            int64_t* p_value);
+
+/**
+ * @brief      Read a floating point value from a parsed document
+ * @param      p_doc      Document from ini_open()
+ * @param      p_section  Section name (case-insensitive)
+ * @param      p_key      Key name (case-insensitive)
+ * @param      p_value    Receives the value, unchanged on failure
+ * @return     0 on success, negative error code on failure.
+ * @details    The decimal point is always '.', whatever the C locale.
+ */
+LIB_EXPORT int
+ini_get_double(const ini_doc_t* p_doc,
+               const char* p_section,
+               const char* p_key,
+               double* p_value);
+
+/**
+ * @brief      Read a boolean value from a parsed document
+ * @param      p_doc      Document from ini_open()
+ * @param      p_section  Section name (case-insensitive)
+ * @param      p_key      Key name (case-insensitive)
+ * @param      p_value    Receives 1 or 0, unchanged on failure
+ * @return     0 on success, negative error code on failure.
+ * @details    Accepts true/false, yes/no, on/off, 1/0 and
+ *             enabled/disabled in any case.
+ */
+LIB_EXPORT int
+ini_get_bool(const ini_doc_t* p_doc,
+             const char* p_section,
+             const char* p_key,
+             int* p_value);
+
+/**
+ * @brief      Read a duration from a parsed document
+ * @param      p_doc      Document from ini_open()
+ * @param      p_section  Section name (case-insensitive)
+ * @param      p_key      Key name (case-insensitive)
+ * @param      p_ns       Receives nanoseconds, unchanged on failure
+ * @return     0 on success, negative error code on failure.
+ * @details    Number and unit pairs with units ns, us, ms, s, m, h and d,
+ *             such as 10ms, 1.5s or 1h30m. A number without unit is in
+ *             seconds.
+ */
+LIB_EXPORT int
+ini_get_duration(const ini_doc_t* p_doc,
+                 const char* p_section,
+                 const char* p_key,
+                 int64_t* p_ns);
+
+/**
+ * @brief      Read several keys with a single pass over the file
+ * @param      filename  Path to the INI file
+ * @param      p_query   Array of lookups, result is set for each entry
+ * @param      count     Number of entries in p_query
+ * @return     Number of keys found, or negative error code if the file
+ *             could not be read.
+ */
+LIB_EXPORT int
+ini_read_keys(const char* filename,
+              ini_query_t* p_query,
+              size_t count);
+
+/**
+ * @brief      Read several keys from INI text held in memory
+ * @param      p_buf    INI text, need not be null terminated
+ * @param      size     Length of p_buf in bytes
+ * @param      p_query  Array of lookups, result is set for each entry
+ * @param      count    Number of entries in p_query
+ * @return     Number of keys found, or negative error code.
+ * @details    Stops scanning once every key is found.
+ */
+LIB_EXPORT int
+ini_read_keys_mem(const char* p_buf,
+                  size_t size,
+                  ini_query_t* p_query,
+                  size_t count);
+
+/**
+ * @brief      Callback for section enumeration
+ * @param      p_key      Key name, null terminated
+ * @param      key_len    Length of key name
+ * @param      p_value    Parsed value, null terminated
+ * @param      value_len  Length of value
+ * @param      p_user     User pointer
+ * @return     0 to continue, non-zero to stop the enumeration.
+ * @details    Pointers are only valid during the callback.
+ */
+typedef int (*ini_section_cb)(const char* p_key,
+                              size_t key_len,
+                              const char* p_value,
+                              size_t value_len,
+                              void* p_user);
+
+/**
+ * @brief      Enumerate all keys of a section in a parsed document
+ * @param      p_doc      Document from ini_open()
+ * @param      p_section  Section name (case-insensitive)
+ * @param      callback   Called for each key/value pair in file order
+ * @param      p_user     Passed to callback
+ * @return     Number of pairs visited, or negative error code. Returns
+ *             End of File if the section does not exist.
+ * @details    Duplicate section headers are enumerated as one section.
+ */
+LIB_EXPORT int
+ini_doc_section(const ini_doc_t* p_doc,
+                const char* p_section,
+                ini_section_cb callback,
+                void* p_user);
+
+/**
+ * @brief      Enumerate all keys of a section with a single scan
+ * @param      filename   Path to the INI file
+ * @param      p_section  Section name (case-insensitive)
+ * @param      callback   Called for each key/value pair in file order
+ * @param      p_user     Passed to callback
+ * @return     Number of pairs visited, or negative error code.
+ */
+LIB_EXPORT int
+ini_get_section(const char* filename,
+                const char* p_section,
+                ini_section_cb callback,
+                void* p_user);
+
+/**
+ * @brief      Enumerate all keys of a section in INI text held in memory
+ * @param      p_buf      INI text, need not be null terminated
+ * @param      size       Length of p_buf in bytes
+ * @param      p_section  Section name (case-insensitive)
+ * @param      callback   Called for each key/value pair in file order
+ * @param      p_user     Passed to callback
+ * @return     Number of pairs visited, or negative error code.
+ */
+LIB_EXPORT int
+ini_get_section_mem(const char* p_buf,
+                    size_t size,
+                    const char* p_section,
+                    ini_section_cb callback,
+                    void* p_user);
+
+/**
+ * @brief      Callbacks for ini_parse_stream(), any of them may be NULL
+ * @details    Names and values are views into the line buffer, valid only
+ *             during the callback and not null terminated. Quoted values
+ *             are decoded. Each callback returns 0 to continue or non-zero
+ *             to stop the parse.
+ */
+typedef struct ini_handler {
+    /** Section header, trimmed name */
+    int (*on_section)(const char* p_name, size_t name_len, void* p_user);
+    /** Key/value pair, section is empty before the first header */
+    int (*on_key)(const char* p_section, size_t section_len,
+                  const char* p_key, size_t key_len,
+                  const char* p_value, size_t value_len, void* p_user);
+    /** Comment line, text after ';' or '#' trimmed */
+    int (*on_comment)(const char* p_text, size_t len, void* p_user);
+    /** Line that is neither of the above, line_no counts from 1 */
+    int (*on_error)(size_t line_no, const char* p_line, size_t len, void* p_user);
+} ini_handler_t;
+
+/**
+ * @brief      Parse an open file once, calling handlers for each line
+ * @param      file       Stream positioned at the start of the INI data
+ * @param      p_handler  Callbacks
+ * @param      p_user     Passed to every callback
+ * @return     Number of key/value pairs visited, or negative error code.
+ * @details    Memory use is bounded by the longest line, nothing is
+ *             kept between lines except the current section name.
+ *             Duplicate keys are reported as they appear.
+ */
+LIB_EXPORT int
+ini_parse_stream(FILE* file,
+                 const ini_handler_t* p_handler,
+                 void* p_user);
+
+/**
+ * @brief      Open and stream-parse an INI file, see ini_parse_stream()
+ * @param      filename   Path to the INI file
+ * @param      p_handler  Callbacks
+ * @param      p_user     Passed to every callback
+ * @return     Number of key/value pairs visited, or negative error code.
+ */
+LIB_EXPORT int
+ini_parse_file(const char* filename,
+               const ini_handler_t* p_handler,
+               void* p_user);
+
+/**
+ * @brief      Stream-parse INI text held in memory, see ini_parse_stream()
+ * @param      p_buf      INI text, need not be null terminated
+ * @param      size       Length of p_buf in bytes
+ * @param      p_handler  Callbacks
+ * @param      p_user     Passed to every callback
+ * @return     Number of key/value pairs visited, or negative error code.
+ * @details    Nothing is copied: section, key and unquoted values are
+ *             views into p_buf and stay valid as long as it does. Only
+ *             quoted values are decoded into a scratch buffer that is
+ *             valid during the callback.
+ */
+LIB_EXPORT int
+ini_parse_buffer(const char* p_buf,
+                 size_t size,
+                 const ini_handler_t* p_handler,
+                 void* p_user);
+
+/**
+ * @brief      Memory held by a document, from ini_doc_memory()
+ */
+typedef struct ini_doc_mem {
+    size_t keys;            /**< Key/value pairs */
+    size_t sections;        /**< Section headers, duplicates counted */
+    size_t names;           /**< Interned section and key names */
+    size_t string_bytes;    /**< Bytes of names and values */
+    size_t arena_bytes;     /**< Arena bytes reserved for strings */
+    size_t table_bytes;     /**< Entry, section, hash and conversion tables */
+    size_t total_bytes;     /**< All memory owned by the document */
+    double bytes_per_key;   /**< total_bytes per key */
+} ini_doc_mem_t;
+
+/**
+ * @brief      Report the memory used by a document
+ * @param      p_doc  Document from ini_open() or ini_open_mem()
+ * @param      p_mem  Receives the report
+ * @return     0 on success, negative error code on failure.
+ * @details    Names and values live in one arena per document that is
+ *             released in one go. Each distinct spelling of a section or
+ *             key name is stored once, with a lowercased copy and its
+ *             hash. total_bytes is what the parse cache charges against
+ *             its limit. For a compiled image the strings and tables are
+ *             part of the mapping and arena_bytes is 0.
+ */
+LIB_EXPORT int
+ini_doc_memory(const ini_doc_t* p_doc,
+               ini_doc_mem_t* p_mem);
+
+/**
+ * @brief      Release a document returned by ini_open()
+ * @param      p_doc  Document handle, NULL is ignored
+ */
+LIB_EXPORT void
+ini_close(ini_doc_t* p_doc);
+
+
+/**
+ * @brief      Hot-reload watcher handle
+ */
+typedef struct ini_watch ini_watch_t;
+
+/**
+ * @brief      Watch an INI file and reload it in the background
+ * @param      filename  Path to the INI file
+ * @param      pp_watch  Receives the watcher handle on success
+ * @return     0 on success, negative error code on failure.
+ * @details    The file is parsed once before returning. A background
+ *             thread re-parses it when it changes (inotify on Linux,
+ *             polling elsewhere) and publishes the new document with an
+ *             atomic pointer swap. A failed parse keeps the previous
+ *             document. Not available on Windows.
+ */
+LIB_EXPORT int
+ini_watch_start(const char* filename,
+                ini_watch_t** pp_watch);
+
+/**
+ * @brief      Stop the watcher and release the current document
+ * @param      p_watch  Watcher handle, NULL is ignored
+ * @details    No reader may hold a document when stopping.
+ */
+LIB_EXPORT void
+ini_watch_stop(ini_watch_t* p_watch);
+
+/**
+ * @brief      Get the current document without blocking
+ * @param      p_watch  Watcher from ini_watch_start()
+ * @param      pp_doc   Receives the current immutable document
+ * @return     Token for ini_watch_release(), or negative error code.
+ * @details    Lock-free, safe from any number of threads. The document
+ *             stays valid until released. Hold it briefly, a reload
+ *             frees the old document only after all readers released it.
+ */
+LIB_EXPORT int
+ini_watch_acquire(ini_watch_t* p_watch,
+                  const ini_doc_t** pp_doc);
+
+/**
+ * @brief      Release a document from ini_watch_acquire()
+ * @param      p_watch  Watcher handle
+ * @param      token    Token returned by ini_watch_acquire()
+ */
+LIB_EXPORT void
+ini_watch_release(ini_watch_t* p_watch,
+                  int token);
+
+/**
+ * @brief      Number of reloads published by the watcher
+ * @param      p_watch  Watcher handle
+ */
+LIB_EXPORT uint64_t
+ini_watch_generation(ini_watch_t* p_watch);
 
 #ifdef __cplusplus
 }
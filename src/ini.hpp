@@ -0,0 +1,236 @@
+/*****************************************************************************
+ * @file      ini.hpp
+ * @author    Peter Hillerström <prohstream@gmail.com>
+ * @copyright 2025, Peter Hillerström
+ * @license   MIT
+ * @date      7 jun 2025
+ ****************************************************************************/
+/**
+ * @brief     C++17 wrapper for parsed INI documents
+ * @details   Header-only, links against the C library. Values are
+ *            std::string_view into the document and stay valid while the
+ *            Document lives. Keys known at compile time are hashed by the
+ *            compiler, see settings::Key.
+ * @ingroup   Settings
+ ****************************************************************************/
+#ifndef INI_HPP_
+#define INI_HPP_
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "ini.h"
+
+namespace settings {
+
+/**
+ * @brief      FNV-1a 64 bit over ASCII lowercased characters
+ * @param      hash  Start value
+ * @param      str   Characters to add
+ * @return     Updated hash, same folding as the C library.
+ */
+constexpr uint64_t
+hash_str(uint64_t hash,
+         std::string_view str) noexcept
+{
+    for (char c : str) {
+        hash ^= static_cast<unsigned char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief      Hash of a section/key pair
+ * @param      section  Section name
+ * @param      key      Key name
+ * @return     Same value as ini_key_hash().
+ */
+constexpr uint64_t
+key_hash(std::string_view section,
+         std::string_view key) noexcept
+{
+    return hash_str(hash_str(0xcbf29ce484222325ULL, section) * 0x100000001b3ULL, key);
+}
+
+/**
+ * @brief      Section/key pair with its hash
+ * @details    Declare as constexpr to hash at compile time:
+ *             constexpr settings::Key timeout{"net", "timeout"};
+ */
+struct Key {
+    std::string_view section;
+    std::string_view key;
+    uint64_t hash;
+
+    constexpr Key(std::string_view section,
+                  std::string_view key) noexcept
+        : section(section), key(key), hash(key_hash(section, key)) {}
+};
+
+/**
+ * @brief      Owning handle of a parsed document
+ * @details    Move-only, the document is closed by the destructor. Lookups
+ *             are const and safe from many threads.
+ */
+class Document {
+public:
+    Document() noexcept = default;
+
+    /**
+     * @brief      Parse a file, check with operator bool or error()
+     * @param      filename  Path to the INI file
+     */
+    explicit Document(const char* filename) noexcept
+        : m_error(ini_open(filename, &m_doc)) {}
+
+    /**
+     * @brief      Parse INI text held in memory, see ini_open_mem()
+     * @param      text  INI text, copied into the document
+     */
+    static Document from_buffer(std::string_view text) noexcept
+    {
+        Document doc;
+        doc.m_error = ini_open_mem(text.data(), text.size(), &doc.m_doc);
+        return doc;
+    }
+
+    ~Document() { ini_close(m_doc); }
+
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+
+    Document(Document&& other) noexcept
+        : m_doc(std::exchange(other.m_doc, nullptr)), m_error(other.m_error) {}
+
+    Document& operator=(Document&& other) noexcept
+    {
+        if (this != &other) {
+            ini_close(m_doc);
+            m_doc = std::exchange(other.m_doc, nullptr);
+            m_error = other.m_error;
+        }
+        return *this;
+    }
+
+    explicit operator bool() const noexcept { return m_doc != nullptr; }
+
+    /** @brief Error code of ini_open(), 0 when open */
+    int error() const noexcept { return m_error; }
+
+    /** @brief Underlying C handle for the rest of the C API */
+    const ini_doc_t* handle() const noexcept { return m_doc; }
+
+    /**
+     * @brief      Look up a key by name
+     * @return     View into the document, empty optional when missing.
+     */
+    std::optional<std::string_view>
+    get(const char* section,
+        const char* key) const noexcept
+    {
+        const char* p_value = nullptr;
+        size_t len = 0;
+        if (ini_get_view(m_doc, section, key, &p_value, &len) < 0) return std::nullopt;
+        return std::string_view(p_value, len);
+    }
+
+    /**
+     * @brief      Look up a key by its precomputed hash
+     * @return     View into the document, empty optional when missing.
+     * @details    No hashing and no name compares, see ini_get_view_hash().
+     */
+    std::optional<std::string_view>
+    get(const Key& key) const noexcept
+    {
+        const char* p_value = nullptr;
+        size_t len = 0;
+        if (ini_get_view_hash(m_doc, key.hash, &p_value, &len) < 0) return std::nullopt;
+        return std::string_view(p_value, len);
+    }
+
+    /** @brief Value of the key, or fallback when missing */
+    std::string_view
+    get_or(const Key& key,
+           std::string_view fallback) const noexcept
+    {
+        return get(key).value_or(fallback);
+    }
+
+    /** @brief Integer value, fallback when missing or malformed */
+    int64_t
+    get_int(const char* section,
+            const char* key,
+            int64_t fallback = 0) const noexcept
+    {
+        ini_get_int(m_doc, section, key, &fallback);
+        return fallback;
+    }
+
+    /** @brief Floating point value, fallback when missing or malformed */
+    double
+    get_double(const char* section,
+               const char* key,
+               double fallback = 0) const noexcept
+    {
+        ini_get_double(m_doc, section, key, &fallback);
+        return fallback;
+    }
+
+    /** @brief Boolean value, fallback when missing or malformed */
+    bool
+    get_bool(const char* section,
+             const char* key,
+             bool fallback = false) const noexcept
+    {
+        int value = fallback;
+        ini_get_bool(m_doc, section, key, &value);
+        return value != 0;
+    }
+
+    /** @brief Duration in nanoseconds, fallback when missing or malformed */
+    int64_t
+    get_duration(const char* section,
+                 const char* key,
+                 int64_t fallback = 0) const noexcept
+    {
+        ini_get_duration(m_doc, section, key, &fallback);
+        return fallback;
+    }
+
+    /**
+     * @brief      Visit all keys of a section in file order
+     * @param      section  Section name (case-insensitive)
+     * @param      fn       Called as fn(key, value) with string views,
+     *                      returning false stops when fn returns bool
+     * @return     Number of pairs visited, or negative error code.
+     */
+    template <class Fn>
+    int
+    for_each(const char* section,
+             Fn&& fn) const
+    {
+        using Callable = std::remove_reference_t<Fn>;
+        return ini_doc_section(m_doc, section,
+            [](const char* p_key, size_t key_len, const char* p_value, size_t value_len, void* p_user) -> int {
+                Callable& callable = *static_cast<Callable*>(p_user);
+                std::string_view key(p_key, key_len), value(p_value, value_len);
+                if constexpr (std::is_same_v<std::invoke_result_t<Callable&, std::string_view, std::string_view>, bool>) {
+                    return callable(key, value) ? 0 : 1;
+                } else {
+                    callable(key, value);
+                    return 0;
+                }
+            }, const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+
+private:
+    ini_doc_t* m_doc = nullptr;
+    int m_error = 0;
+};
+
+} /* namespace settings */
+
+#endif /* INI_HPP_ */
@@ -2,10 +2,111 @@
 #include <string.h>
 #include <stdint.h>
 #include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <dirent.h>
 #include "../ini.h"
 
 #define MAX_LINE_LENGTH (20)
 
+struct section_list { int count; char keys[128]; };
+
+static int
+collect_keys(const char* p_key, size_t key_len, const char* p_value, size_t value_len, void* p_user)
+{
+    struct section_list* p_list = p_user;
+    assert(strlen(p_key) == key_len && strlen(p_value) == value_len);
+    size_t used = strlen(p_list->keys);
+    if (used + key_len + 2 <= sizeof(p_list->keys)) { /* Only counted once full */
+        memcpy(p_list->keys + used, p_key, key_len);
+        strcpy(p_list->keys + used + key_len, ",");
+    }
+    p_list->count++;
+    return 0;
+}
+
+static int
+stop_after_one(const char* p_key, size_t key_len, const char* p_value, size_t value_len, void* p_user)
+{
+    (void)p_key; (void)key_len; (void)p_value; (void)value_len;
+    ((struct section_list*)p_user)->count++;
+    return 1;
+}
+
+static int
+hash_pairs(const char* p_key, size_t key_len, const char* p_value, size_t value_len, void* p_user)
+{
+    uint64_t* p_hash = p_user;
+    for (size_t i = 0; i < key_len; ++i) *p_hash = (*p_hash ^ (unsigned char)p_key[i]) * 0x100000001b3ULL;
+    for (size_t i = 0; i < value_len; ++i) *p_hash = (*p_hash ^ (unsigned char)p_value[i]) * 0x100000001b3ULL;
+    return 0;
+}
+
+/* Stream events as text, "S:name K:section/key=value C:text E:line" */
+static int
+on_section(const char* p_name, size_t name_len, void* p_user)
+{
+    snprintf((char*)p_user + strlen(p_user), 256 - strlen(p_user), "S:%.*s ", (int)name_len, p_name);
+    return 0;
+}
+
+static int
+on_key(const char* p_section, size_t section_len, const char* p_key, size_t key_len,
+       const char* p_value, size_t value_len, void* p_user)
+{
+    snprintf((char*)p_user + strlen(p_user), 256 - strlen(p_user), "K:%.*s/%.*s=%.*s ",
+             (int)section_len, p_section, (int)key_len, p_key, (int)value_len, p_value);
+    return strncmp(p_key, "stop", key_len) == 0;
+}
+
+static int
+on_comment(const char* p_text, size_t len, void* p_user)
+{
+    snprintf((char*)p_user + strlen(p_user), 256 - strlen(p_user), "C:%.*s ", (int)len, p_text);
+    return 0;
+}
+
+static int
+on_error(size_t line_no, const char* p_line, size_t len, void* p_user)
+{
+    (void)p_line; (void)len;
+    snprintf((char*)p_user + strlen(p_user), 256 - strlen(p_user), "E:%zu ", line_no);
+    return 0;
+}
+
+static void*
+read_concurrently(void* p_arg)
+{
+    char buffer[MAX_LINE_LENGTH];
+    char message[128];
+    for (int i = 0; i < 1000; ++i) {
+        if (ini_read_key(p_arg, "MySection", "count", buffer, sizeof(buffer)) != 1 || strcmp(buffer, "4") != 0) return p_arg;
+        snprintf(message, sizeof(message), "%s", ini_error_string(-1002)); /* Per-thread buffer */
+        if (strcmp(message, ini_error_string(-1002)) != 0) return p_arg;
+    }
+    return NULL;
+}
+
+static void*
+write_concurrently(void* p_arg)
+{
+    static atomic_int next;
+    char key[16];
+    int id = atomic_fetch_add(&next, 1);
+    for (int i = 0; i < 25; ++i) {
+        snprintf(key, sizeof(key), "t%d_%d", id, i);
+        if (ini_write_key(p_arg, "Writers", key, "1", NULL) != 0) return p_arg;
+    }
+    return NULL;
+}
+
 int main(void) {
     int version = ini_version();
     assert(version >= 1000000 && version < 2000000);
@@ -53,6 +154,557 @@ int main(void) {
     printf("bad read: \'%s\' = %i (\'%s\')\n", buffer, result, ini_error_string(result));
     assert(result < 0);
     printf("✅ Test passed: missing ini\n");
+    ini_doc_t* doc = NULL;
+    result = ini_open(inifile1, &doc);
+    assert(result == 0 && doc != NULL);
+    result = ini_get(doc, "MYSECTION", "PI", buffer, MAX_LINE_LENGTH);
+    printf("get: \'%s\' = %i (\'%s\')\n", buffer, result, ini_error_string(result));
+    assert(result == 7);
+    assert(strcmp(buffer, "3.14159") == 0);
+    result = ini_get(doc, "AnotherSection", "path", buffer, MAX_LINE_LENGTH);
+    assert(result > 0 && strncmp(buffer, "C:\\path\\to\\", 11) == 0);
+    result = ini_get(doc, "AnotherSection", "pi", buffer, MAX_LINE_LENGTH);
+    assert(result == -4); /* Key in other section */
+    assert(strlen(buffer) == 0);
+    ini_close(doc);
+    result = ini_open("./does_not_exist.ini", &doc);
+    assert(result < 0 && doc == NULL);
+    printf("✅ Test passed: open/get/close\n");
+    char value1[MAX_LINE_LENGTH], value2[MAX_LINE_LENGTH], value3[4];
+    ini_query_t query[] = {
+        { "MySection", "pi", value1, sizeof(value1), 0 },
+        { "MySection", "nokey", value2, sizeof(value2), 0 },
+        { "mysection", "PI", value3, sizeof(value3), 0 },
+    };
+    result = ini_read_keys(inifile1, query, 3);
+    assert(result == 2);
+    assert(query[0].result == 7 && strcmp(value1, "3.14159") == 0);
+    assert(query[1].result == -4 && strlen(value2) == 0);
+    assert(query[2].result == 3 && strcmp(value3, "3.1") == 0);
+    assert(ini_read_keys("./does_not_exist.ini", query, 3) < 0);
+    printf("✅ Test passed: batch read\n");
+    ini_txn_t* txn = NULL;
+    result = ini_begin(inifile1, &txn);
+    assert(result == 0 && txn != NULL);
+    assert(ini_set(txn, "MySection", "count", "1", NULL) == 0);
+    assert(ini_set(txn, "MySection", "COUNT", "2", "Counter") == 0); /* Replaces previous set */
+    assert(ini_set(txn, "NewSection", "name", "new", NULL) == 0);
+    assert(ini_set(txn, "AnotherSection", "path", "/tmp", NULL) == 0);
+    assert(ini_delete(txn, "MySection", "pi") == 0);
+    result = ini_commit(txn);
+    printf("commit = %s\n", ini_error_string(result));
+    assert(result == 0);
+    result = ini_read_key(inifile1, "MySection", "count", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "2") == 0);
+    result = ini_read_key(inifile1, "MySection", "pi", buffer, MAX_LINE_LENGTH);
+    assert(result == -4);
+    result = ini_read_key(inifile1, "NewSection", "name", buffer, MAX_LINE_LENGTH);
+    assert(result == 3 && strcmp(buffer, "new") == 0);
+    result = ini_read_key(inifile1, "AnotherSection", "path", buffer, MAX_LINE_LENGTH);
+    assert(result == 4 && strcmp(buffer, "/tmp") == 0);
+    result = ini_read_key(inifile1, "MySection", "path", buffer, MAX_LINE_LENGTH);
+    assert(result > 0); /* New key stays in its own section */
+    assert(ini_begin(inifile1, &txn) == 0);
+    assert(ini_set(txn, "MySection", "pi", "3.14159", NULL) == 0);
+    ini_abort(txn);
+    result = ini_read_key(inifile1, "MySection", "pi", buffer, MAX_LINE_LENGTH);
+    assert(result == -4);
+    printf("✅ Test passed: transaction\n");
+    char long_value[1200], long_buffer[1300];
+    for (size_t i = 0; i < sizeof(long_value) - 1; ++i) long_value[i] = 'A' + i % 26;
+    long_value[sizeof(long_value) - 1] = '\0';
+    result = ini_write_key(inifile1, "MySection", "cert", long_value, NULL);
+    assert(result == 0);
+    result = ini_write_key(inifile1, "MySection", "after", "1", NULL); /* Rewrite keeps long line */
+    assert(result == 0);
+    result = ini_read_key(inifile1, "MySection", "cert", long_buffer, sizeof(long_buffer));
+    assert(result == (int)strlen(long_value) && strcmp(long_buffer, long_value) == 0);
+    result = ini_read_key(inifile1, "MySection", "after", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "1") == 0);
+    printf("✅ Test passed: long lines\n");
+    struct section_list list = { 0, "" };
+    result = ini_get_section(inifile1, "mysection", collect_keys, &list);
+    printf("section: %i keys \'%s\'\n", result, list.keys);
+    assert(result == 4 && list.count == 4);
+    assert(strcmp(list.keys, "path,COUNT,cert,after,") == 0);
+    list.count = 0;
+    result = ini_get_section(inifile1, "MySection", stop_after_one, &list);
+    assert(result == 1 && list.count == 1);
+    result = ini_get_section(inifile1, "NoSection", collect_keys, &list);
+    assert(result == -4);
+    printf("✅ Test passed: section enumeration\n");
+    ini_cache_stats_t stats;
+    ini_cache_flush();
+    ini_cache_stats(&stats);
+    assert(stats.entries == 0 && stats.mem_size == 0);
+    uint64_t hits = stats.hits, misses = stats.misses;
+    result = ini_read_key(inifile1, "MySection", "count", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "2") == 0);
+    result = ini_read_key(inifile1, "MySection", "after", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "1") == 0);
+    ini_cache_stats(&stats);
+    assert(stats.misses == misses + 1 && stats.hits == hits + 1);
+    assert(stats.entries == 1 && stats.mem_size > 0 && stats.mem_size <= stats.limit);
+    result = ini_write_key(inifile1, "MySection", "count", "3", NULL); /* Invalidates */
+    assert(result == 0);
+    result = ini_read_key(inifile1, "MySection", "count", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "3") == 0);
+    ini_cache_limit(0); /* Disable */
+    result = ini_read_key(inifile1, "MySection", "count", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "3") == 0);
+    ini_cache_stats(&stats);
+    assert(stats.entries == 0 && stats.limit == 0);
+    ini_cache_limit(16 * 1024 * 1024);
+    const char lru_file[] = "./test/test_lru.ini";
+    assert(ini_write_key(lru_file, "lru", "key", "b", NULL) == 0);
+    assert(ini_read_key(inifile1, "MySection", "count", buffer, MAX_LINE_LENGTH) == 1);
+    assert(ini_read_key(lru_file, "lru", "key", buffer, MAX_LINE_LENGTH) == 1);
+    assert(ini_read_key(inifile1, "MySection", "count", buffer, MAX_LINE_LENGTH) == 1); /* Most recent again */
+    ini_cache_stats(&stats);
+    ini_cache_limit(stats.mem_size - 1); /* Room for one */
+    hits = stats.hits;
+    assert(ini_read_key(inifile1, "MySection", "count", buffer, MAX_LINE_LENGTH) == 1);
+    ini_cache_stats(&stats);
+    assert(stats.entries == 1 && stats.hits == hits + 1); /* Least recently used went */
+    ini_cache_limit(16 * 1024 * 1024);
+    remove(lru_file);
+    printf("✅ Test passed: parse cache\n");
+    ini_watch_t* watch = NULL;
+    const ini_doc_t* snapshot = NULL;
+    result = ini_watch_start(inifile1, &watch);
+    assert(result == 0 && watch != NULL);
+    int token = ini_watch_acquire(watch, &snapshot);
+    assert(token >= 0);
+    result = ini_get(snapshot, "MySection", "count", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "3") == 0);
+    ini_watch_release(watch, token);
+    result = ini_write_key(inifile1, "MySection", "count", "4", NULL);
+    assert(result == 0);
+    for (int i = 0; i < 200 && ini_watch_generation(watch) == 0; ++i) nanosleep(&(struct timespec){ 0, 10000000 }, NULL);
+    assert(ini_watch_generation(watch) >= 1);
+    token = ini_watch_acquire(watch, &snapshot);
+    result = ini_get(snapshot, "MySection", "count", buffer, MAX_LINE_LENGTH);
+    ini_watch_release(watch, token);
+    assert(result == 1 && strcmp(buffer, "4") == 0);
+    ini_watch_stop(watch);
+    printf("✅ Test passed: watch reload\n");
+    const char inifile2[] = "./test/test2.ini";
+    FILE* file = fopen(inifile2, "wb");
+    assert(file != NULL);
+    fputs("[crlf]\r\nkey = value\r\n[ Long Section Name With Spaces ]\r\n"
+          "url = http://localhost:8080/a/long/path/name/for/the/vector/scanner ; comment\r\n"
+          "last=\"end\"", file); /* No newline at EOF */
+    fclose(file);
+    result = ini_read_key(inifile2, "crlf", "key", buffer, MAX_LINE_LENGTH);
+    assert(result == 5 && strcmp(buffer, "value") == 0);
+    result = ini_read_key(inifile2, "long section name with spaces", "last", buffer, MAX_LINE_LENGTH);
+    assert(result == 3 && strcmp(buffer, "end") == 0);
+    char url[80];
+    result = ini_read_key(inifile2, "long section name with spaces", "URL", url, sizeof(url));
+    assert(result == 61 && strcmp(url, "http://localhost:8080/a/long/path/name/for/the/vector/scanner") == 0);
+    file = fopen(inifile2, "wb");
+    fclose(file);
+    result = ini_read_key(inifile2, "crlf", "key", buffer, MAX_LINE_LENGTH);
+    assert(result == -4); /* Empty file */
+    remove(inifile2);
+    printf("✅ Test passed: mapped read\n");
+    file = fopen(inifile2, "wb");
+    assert(file != NULL);
+    fputs("[typed]\nint = -42\nhex = 0x1F\nsize = 64k\nhuge = 9223372036854775808\npi = 3.14159\n"
+          "tiny = 1e-300\nbad = 1,5\nflag = Yes\noff = OFF\ntimeout = 10ms\nlong = 1h30m\nhalf = 1.5\n"
+          "plus = +5\nminus = -5\nover = 1e400\nforever = -inf\n", file);
+    fclose(file);
+    ini_doc_t* p_typed = NULL;
+    assert(ini_open(inifile2, &p_typed) == 0);
+    int64_t number = 0;
+    double real = 0;
+    int flag = -1;
+    assert(ini_get_int(p_typed, "typed", "int", &number) == 0 && number == -42);
+    assert(ini_get_int(p_typed, "typed", "int", &number) == 0 && number == -42); /* Cached */
+    assert(ini_get_int(p_typed, "typed", "hex", &number) == 0 && number == 31);
+    assert(ini_get_int(p_typed, "typed", "size", &number) == 0 && number == 65536);
+    assert(ini_get_int(p_typed, "typed", "huge", &number) == -(ERANGE + 1000) && number == 65536);
+    assert(ini_get_int(p_typed, "typed", "pi", &number) < 0);
+    assert(ini_get_int(p_typed, "typed", "missing", &number) == -4);
+    assert(ini_get_double(p_typed, "typed", "pi", &real) == 0 && real == 3.14159);
+    assert(ini_get_double(p_typed, "typed", "tiny", &real) == 0 && real == 1e-300);
+    assert(ini_get_double(p_typed, "typed", "int", &real) == 0 && real == -42.0); /* Int cached first */
+    assert(ini_get_double(p_typed, "typed", "bad", &real) < 0);
+    assert(ini_get_double(p_typed, "typed", "over", &real) == -(ERANGE + 1000) && real == -42.0);
+    assert(ini_get_double(p_typed, "typed", "forever", &real) == 0 && isinf(real) && real < 0);
+    assert(ini_get_bool(p_typed, "typed", "flag", &flag) == 0 && flag == 1);
+    assert(ini_get_bool(p_typed, "typed", "off", &flag) == 0 && flag == 0);
+    assert(ini_get_bool(p_typed, "typed", "pi", &flag) < 0);
+    assert(ini_get_duration(p_typed, "typed", "timeout", &number) == 0 && number == 10000000);
+    assert(ini_get_duration(p_typed, "typed", "long", &number) == 0 && number == 5400000000000LL);
+    assert(ini_get_duration(p_typed, "typed", "half", &number) == 0 && number == 1500000000);
+    assert(ini_get_duration(p_typed, "typed", "flag", &number) < 0);
+    assert(ini_get_duration(p_typed, "typed", "plus", &number) == 0 && number == 5000000000LL);
+    assert(ini_get_duration(p_typed, "typed", "minus", &number) == 0 && number == -5000000000LL);
+    ini_close(p_typed);
+    remove(inifile2);
+    printf("✅ Test passed: typed getters\n");
+    file = fopen(inifile2, "wb");
+    assert(file != NULL);
+    fputs("top = 1\n[one]\na = 1\nB = \"two\"\na = dup\n[Two]\nsize = 64k\n[ONE]\nc = 3\n", file);
+    fclose(file);
+    char image[64];
+    snprintf(image, sizeof(image), "%s.bin", inifile2);
+    assert(ini_compile(inifile2, NULL) == 0);
+    ini_doc_t* p_image = NULL;
+    ini_doc_mem_t image_mem;
+    file = fopen(image, "r+b");
+    assert(file != NULL && fseek(file, 16, SEEK_SET) == 0); /* Source device of the stamp */
+    int dev_byte = fgetc(file);
+    assert(fseek(file, 16, SEEK_SET) == 0 && fputc(dev_byte ^ 1, file) != EOF);
+    fclose(file);
+    assert(ini_open(inifile2, &p_image) == 0 && ini_doc_memory(p_image, &image_mem) == 0);
+    assert(image_mem.arena_bytes > 0); /* Other file system, text parsed */
+    ini_close(p_image);
+    assert(ini_compile(inifile2, NULL) == 0);
+    assert(ini_open(inifile2, &p_image) == 0 && ini_doc_memory(p_image, &image_mem) == 0);
+    assert(image_mem.arena_bytes == 0); /* Image mapped */
+    assert(ini_get(p_image, "", "top", buffer, MAX_LINE_LENGTH) == 1 && strcmp(buffer, "1") == 0);
+    assert(ini_get(p_image, "One", "A", buffer, MAX_LINE_LENGTH) == 1 && strcmp(buffer, "1") == 0); /* First wins */
+    assert(ini_get(p_image, "one", "b", buffer, MAX_LINE_LENGTH) == 3 && strcmp(buffer, "two") == 0);
+    assert(ini_get(p_image, "one", "c", buffer, MAX_LINE_LENGTH) == 1);
+    assert(ini_get(p_image, "one", "size", buffer, MAX_LINE_LENGTH) == -4);
+    assert(ini_get_int(p_image, "two", "size", &number) == 0 && number == 65536);
+    const char* p_view = NULL;
+    size_t view_len = 0;
+    assert(ini_get_view_hash(p_image, ini_key_hash("ONE", "b"), &p_view, &view_len) == 0);
+    assert(view_len == 3 && strcmp(p_view, "two") == 0);
+    assert(ini_get_view(p_image, "one", "a", &p_view, &view_len) == 0 && view_len == 1 && *p_view == '1');
+    struct section_list compiled = { 0, "" };
+    assert(ini_doc_section(p_image, "one", collect_keys, &compiled) == 4);
+    assert(strcmp(compiled.keys, "a,B,a,c,") == 0);
+    ini_close(p_image);
+    result = ini_write_key(inifile2, "one", "c", "4", NULL); /* Image is stale now */
+    assert(result == 0);
+    result = ini_read_key(inifile2, "one", "c", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "4") == 0);
+    remove(image);
+    remove(inifile2);
+    printf("✅ Test passed: compiled image\n");
+    pthread_t threads[4];
+    for (int i = 0; i < 4; ++i) {
+        result = pthread_create(&threads[i], NULL, read_concurrently, (void*)inifile1);
+        assert(result == 0);
+    }
+    for (int i = 0; i < 4; ++i) {
+        void* p_failed = NULL;
+        pthread_join(threads[i], &p_failed);
+        assert(p_failed == NULL);
+    }
+    printf("✅ Test passed: concurrent reads\n");
+    for (int i = 0; i < 4; ++i) {
+        result = pthread_create(&threads[i], NULL, write_concurrently, (void*)inifile1);
+        assert(result == 0);
+    }
+    for (int i = 0; i < 4; ++i) {
+        void* p_failed = NULL;
+        pthread_join(threads[i], &p_failed);
+        assert(p_failed == NULL);
+    }
+    struct section_list writers = { 0, "" };
+    result = ini_get_section(inifile1, "Writers", collect_keys, &writers);
+    assert(result >= 0 && writers.count == 100); /* No lost update */
+    const char new_file[] = "./test/test_new.ini", new_lock[] = "./test/test_new.ini.lock";
+    int lock_fd = open(new_lock, O_RDWR | O_CREAT, 0666);
+    assert(lock_fd >= 0 && flock(lock_fd, LOCK_EX) == 0);
+    result = pthread_create(&threads[0], NULL, write_concurrently, (void*)new_file);
+    assert(result == 0);
+    nanosleep(&(struct timespec){ 0, 50000000 }, NULL);
+    assert(access(new_file, F_OK) != 0); /* Waiting writer has not created it empty */
+    flock(lock_fd, LOCK_UN);
+    close(lock_fd);
+    void* p_failed = NULL;
+    pthread_join(threads[0], &p_failed);
+    assert(p_failed == NULL);
+    struct section_list created = { 0, "" };
+    assert(ini_get_section(new_file, "Writers", collect_keys, &created) == 25);
+    remove(new_file);
+    remove(new_lock);
+    printf("✅ Test passed: concurrent writes\n");
+    ini_stats_t counters;
+    ini_stats_reset();
+    ini_cache_flush();
+    result = ini_stats_get(&counters);
+    if (result == 0) {
+        /* Built with INI_STATS */
+        assert(ini_read_key(inifile1, "MySection", "count", buffer, MAX_LINE_LENGTH) == 1);
+        assert(ini_read_key(inifile1, "MySection", "count", buffer, MAX_LINE_LENGTH) == 1);
+        assert(ini_write_key(inifile1, "Writers", "t0_0", "2", NULL) == 0);
+        assert(ini_stats_get(&counters) == 0);
+        assert(counters.cache_misses == 1 && counters.cache_hits == 1);
+        assert(counters.read_key.count == 2 && counters.commit.count == 1);
+        assert(counters.temp_files == 1 && counters.renames == 1);
+        assert(counters.files_opened >= 2 && counters.lines_scanned > 0 && counters.bytes_written > 0);
+        uint64_t bucketed = 0;
+        for (int i = 0; i < INI_STATS_BUCKETS; ++i) bucketed += counters.read_key.buckets[i];
+        assert(bucketed == counters.read_key.count && counters.read_key.total_ns > 0);
+        ini_stats_reset();
+        assert(ini_stats_get(&counters) == 0 && counters.read_key.count == 0 && counters.renames == 0);
+    } else {
+        assert(result == -13 && counters.read_key.count == 0);
+    }
+    printf("✅ Test passed: stats\n");
+    file = fopen(inifile2, "wb");
+    assert(file != NULL);
+    fputs("[counters]\r\nhits = 3.14 ; note\r\nlast = x", file);
+    fclose(file);
+    struct stat st_before, st_after;
+    assert(stat(inifile2, &st_before) == 0);
+    ini_txn_t* p_patch = NULL;
+    assert(ini_begin(inifile2, &p_patch) == 0 && ini_txn_options(p_patch, INI_WRITE_INPLACE) == 0);
+    assert(ini_set(p_patch, "Counters", "hits", "3.15", NULL) == 0 && ini_set(p_patch, "counters", "last", "y", NULL) == 0);
+    assert(ini_commit(p_patch) == 0);
+    assert(stat(inifile2, &st_after) == 0);
+    assert(st_after.st_ino == st_before.st_ino && st_after.st_size == st_before.st_size); /* Patched */
+    result = ini_read_key(inifile2, "counters", "hits", buffer, MAX_LINE_LENGTH);
+    assert(result == 4 && strcmp(buffer, "3.15") == 0);
+    result = ini_read_key(inifile2, "counters", "last", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "y") == 0);
+    ini_write_options(INI_WRITE_INPLACE);
+    assert(ini_write_key(inifile2, "counters", "hits", "1234567890123", NULL) == 0); /* Does not fit */
+    ini_write_options(0);
+    assert(stat(inifile2, &st_after) == 0 && st_after.st_ino != st_before.st_ino);
+    result = ini_read_key(inifile2, "counters", "hits", buffer, MAX_LINE_LENGTH);
+    assert(result == 13 && strcmp(buffer, "1234567890123") == 0);
+    file = fopen(inifile2, "wb");
+    assert(file != NULL);
+    fputs("[s]\nk = \"aaaaaaaaaaaaaaaaaaaaaaaa\"\nother = 1\n", file);
+    fclose(file);
+    for (int inplace = 1; inplace >= 0; --inplace) {
+        ini_write_options(inplace ? INI_WRITE_INPLACE : 0);
+        assert(ini_write_key(inifile2, "s", "k", "\"b\"\nother = 2", NULL) == 0); /* Quoted, line break escaped */
+        ini_write_options(0);
+        result = ini_read_key(inifile2, "s", "other", buffer, MAX_LINE_LENGTH);
+        assert(result == 1 && strcmp(buffer, "1") == 0); /* No line added */
+        result = ini_read_key(inifile2, "s", "k", buffer, MAX_LINE_LENGTH);
+        assert(result == 13 && strcmp(buffer, "\"b\"\nother = 2") == 0);
+    }
+    remove(inifile2);
+    printf("✅ Test passed: in-place update\n");
+    assert(ini_write_key(inifile2, "durable", "key", "1", NULL) == 0);
+    assert(chmod(inifile2, 0640) == 0);
+    ini_write_options(INI_WRITE_SYNC_DIR);
+    assert(ini_write_key(inifile2, "durable", "key", "2", NULL) == 0);
+    ini_write_options(INI_WRITE_SYNC_DATA);
+    assert(ini_write_key(inifile2, "durable", "other", "3", NULL) == 0);
+    ini_write_options(0);
+    assert(stat(inifile2, &st_after) == 0 && (st_after.st_mode & 0777) == 0640); /* Mode kept */
+    result = ini_read_key(inifile2, "durable", "key", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "2") == 0);
+    DIR* p_dir = opendir("./test");
+    assert(p_dir != NULL);
+    for (struct dirent* p_ent; (p_ent = readdir(p_dir)) != NULL; ) assert(strstr(p_ent->d_name, ".tmp") == NULL);
+    closedir(p_dir);
+    remove(inifile2);
+    char long_dir[256] = "./test/", long_file[512];
+    memset(long_dir + 7, 'd', 200); /* Temp names beyond 256 bytes */
+    assert(mkdir(long_dir, 0777) == 0 || errno == EEXIST);
+    snprintf(long_file, sizeof(long_file), "%s/%0100d.ini", long_dir, 0);
+    assert(ini_write_key(long_file, "long", "path", "1", NULL) == 0);
+    assert(ini_write_key(long_file, "long", "path", "2", NULL) == 0);
+    result = ini_read_key(long_file, "long", "path", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "2") == 0);
+    remove(long_file);
+    strcat(long_file, ".lock");
+    remove(long_file);
+    assert(rmdir(long_dir) == 0); /* No temp files left */
+    printf("✅ Test passed: durable write\n");
+    file = fopen(inifile2, "wb");
+    assert(file != NULL);
+    fputs("[keep]\r\na = 1\r\n\r\n[edit]\r\nb = 2\r\ngone = 3\r\n\r\n[tail]\r\nc = 3", file); /* No newline at EOF */
+    fclose(file);
+    assert(ini_begin(inifile2, &p_patch) == 0);
+    assert(ini_set(p_patch, "edit", "b", "20", NULL) == 0 && ini_delete(p_patch, "edit", "gone") == 0);
+    assert(ini_set(p_patch, "edit", "new", "4", NULL) == 0 && ini_set(p_patch, "tail", "d", "5", NULL) == 0);
+    assert(ini_set(p_patch, "fresh", "e", "6", NULL) == 0);
+    assert(ini_commit(p_patch) == 0);
+    char content[128] = "";
+    file = fopen(inifile2, "rb");
+    assert(file != NULL);
+    content[fread(content, 1, sizeof(content) - 1, file)] = '\0';
+    fclose(file);
+    assert(strcmp(content, "[keep]\r\na = 1\r\n\r\n[edit]\r\nb = 20\r\nnew = 4\r\n\r\n[tail]\r\nc = 3\r\nd = 5\r\n\r\n[fresh]\r\ne = 6\r\n") == 0); /* Line endings kept */
+    remove(inifile2);
+    file = fopen(inifile2, "wb");
+    assert(file != NULL);
+    fputs("[s]\nurl: http://h = 1\n[x = 2\n[t] ; ]\nk = a]b\n", file); /* Lines readers and writers must split alike */
+    fclose(file);
+    result = ini_read_key(inifile2, "s", "url", buffer, MAX_LINE_LENGTH);
+    assert(result == 12 && strcmp(buffer, "http://h = 1") == 0);
+    assert(ini_begin(inifile2, &p_patch) == 0);
+    assert(ini_set(p_patch, "s", "url", "u", NULL) == 0 && ini_set(p_patch, "s", "[x", "3", NULL) == 0);
+    assert(ini_set(p_patch, "t", "k", "v", NULL) == 0);
+    assert(ini_commit(p_patch) == 0);
+    file = fopen(inifile2, "rb");
+    assert(file != NULL);
+    content[fread(content, 1, sizeof(content) - 1, file)] = '\0';
+    fclose(file);
+    assert(strcmp(content, "[s]\nurl = u\n[x = 3\n[t] ; ]\nk = v\n") == 0); /* Same lines replaced, none added */
+    ini_write_options(INI_WRITE_INPLACE);
+    assert(ini_write_key(inifile2, "t", "k", "w", NULL) == 0);
+    ini_write_options(0);
+    result = ini_read_key(inifile2, "t", "k", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "w") == 0);
+    remove(inifile2);
+    printf("✅ Test passed: range copy rewrite\n");
+    assert(ini_write_behind(1000, 0) == 0);
+    for (int i = 0; i <= 500; ++i) {
+        char value[16];
+        snprintf(value, sizeof(value), "%d", i);
+        assert(ini_write_key(inifile2, "behind", "count", value, NULL) == 0);
+        result = ini_read_key(inifile2, "behind", "count", buffer, MAX_LINE_LENGTH); /* Own write, file may not exist yet */
+        assert(result >= 0 && strcmp(buffer, value) == 0);
+    }
+    assert(ini_write_key(inifile2, "behind", "quoted", "\" padded \" ; note", NULL) == 0);
+    result = ini_read_key(inifile2, "behind", "quoted", buffer, MAX_LINE_LENGTH);
+    assert(result == 8 && strcmp(buffer, " padded ") == 0);
+    assert(ini_flush() == 0);
+    assert(ini_write_behind(0, 0) == 0);
+    ini_cache_flush();
+    result = ini_read_key(inifile2, "behind", "count", buffer, MAX_LINE_LENGTH);
+    assert(result == 3 && strcmp(buffer, "500") == 0);
+    struct section_list behind = { 0, "" };
+    result = ini_get_section(inifile2, "behind", collect_keys, &behind);
+    assert(result >= 0 && behind.count == 2); /* Coalesced to one line per key */
+    remove(inifile2);
+    printf("✅ Test passed: write-behind\n");
+    file = fopen(inifile2, "w");
+    assert(file != NULL);
+    fputs("top = 0\n# note \n[ one ]\na = 1 ; c\nbad line\nq = \"x\\ty\" ; c\n[two]\nstop = 2\nafter = 3\n", file);
+    fclose(file);
+    ini_handler_t handler = { on_section, on_key, on_comment, on_error };
+    char events[256] = "";
+    result = ini_parse_file(inifile2, &handler, events);
+    assert(result == 4); /* Stopped at "stop" */
+    assert(strcmp(events, "K:/top=0 C:note S:one K:one/a=1 E:5 K:one/q=x\ty S:two K:two/stop=2 ") == 0);
+    ini_handler_t keys_only = { NULL, NULL, NULL, NULL };
+    assert(ini_parse_file(inifile2, &keys_only, NULL) == 5);
+    assert(ini_parse_file("./test/missing.ini", &keys_only, NULL) == -1002);
+    file = fopen(inifile2, "wb");
+    assert(file != NULL);
+    fputs("[cr]\r\nk = x\ry\r\n", file); /* Bare CR inside the value */
+    fclose(file);
+    result = ini_read_key(inifile2, "cr", "k", buffer, MAX_LINE_LENGTH);
+    assert(result == 3 && strcmp(buffer, "x\ry") == 0);
+    events[0] = '\0';
+    assert(ini_parse_file(inifile2, &handler, events) == 1);
+    assert(strcmp(events, "S:cr K:cr/k=x\ry ") == 0); /* Same value as the mapped reader */
+    remove(inifile2);
+    printf("✅ Test passed: stream parse\n");
+    const char text[] = "[one]\r\na = 1\r\nq = \"x\\ny\"\r\na = dup\r\n[TWO]\r\nb=2\r\n[one]\r\nc = 3 ; tail";
+    size_t text_len = sizeof(text) - 1;
+    result = ini_read_key_mem(text, text_len, "ONE", "A", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "1") == 0); /* First key wins */
+    result = ini_read_key_mem(text, text_len - 7, "one", "c", buffer, MAX_LINE_LENGTH); /* Not null terminated */
+    assert(result == 1 && strcmp(buffer, "3") == 0);
+    result = ini_read_key_mem(text, text_len, "one", "missing", buffer, MAX_LINE_LENGTH);
+    assert(result == -4 && buffer[0] == '\0');
+    char mem_values[3][MAX_LINE_LENGTH];
+    ini_query_t mem_query[4] = {
+        { "one", "q", mem_values[0], MAX_LINE_LENGTH, 0 },
+        { "two", "b", mem_values[1], MAX_LINE_LENGTH, 0 },
+        { "two", "none", mem_values[2], MAX_LINE_LENGTH, 0 },
+        { NULL, "b", NULL, 0, 0 },
+    };
+    assert(ini_read_keys_mem(text, text_len, mem_query, 4) == 2);
+    assert(mem_query[0].result == 3 && strcmp(mem_values[0], "x\ny") == 0);
+    assert(mem_query[1].result == 1 && mem_query[2].result == -4 && mem_query[3].result == -2);
+    assert(ini_open_mem(text, text_len, &doc) == 0);
+    result = ini_get(doc, "one", "c", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "3") == 0);
+    ini_close(doc);
+    struct section_list mem_list = { 0, "" };
+    assert(ini_get_section_mem(text, text_len, "one", collect_keys, &mem_list) == 4);
+    assert(strcmp(mem_list.keys, "a,q,a,c,") == 0);
+    char events_mem[256] = "";
+    assert(ini_parse_buffer(text, text_len, &handler, events_mem) == 5);
+    assert(strcmp(events_mem, "S:one K:one/a=1 K:one/q=x\ny K:one/a=dup S:TWO K:TWO/b=2 S:one K:one/c=3 ") == 0);
+    printf("✅ Test passed: memory parse\n");
+    file = fopen(inifile2, "w");
+    assert(file != NULL);
+    fputs("top = 0\n", file);
+    for (int i = 0; i < 100000; ++i) {
+        fprintf(file, "[s%d]\r\nkey = %d\r\nname = value_%d_padding\r\n", i, i, i);
+        if (i % 1000 == 0) fprintf(file, "[dup]\nfirst = %d\nk%d = %d\n", i, i / 1000, i);
+    }
+    fclose(file);
+    ini_doc_t* p_parsed[2] = { NULL, NULL };
+    uint64_t dup_hash[2] = { 0, 0 };
+    for (int t = 0; t < 2; ++t) {
+        ini_parse_threads(t == 0 ? 1 : 4);
+        assert(ini_open(inifile2, &p_parsed[t]) == 0);
+        assert(ini_doc_section(p_parsed[t], "dup", hash_pairs, &dup_hash[t]) == 200);
+        result = ini_get(p_parsed[t], "dup", "first", buffer, MAX_LINE_LENGTH);
+        assert(result == 1 && strcmp(buffer, "0") == 0); /* First key wins across chunks */
+        result = ini_get(p_parsed[t], "", "top", buffer, MAX_LINE_LENGTH);
+        assert(result == 1 && strcmp(buffer, "0") == 0);
+        result = ini_get(p_parsed[t], "S99999", "key", buffer, MAX_LINE_LENGTH);
+        assert(result == 5 && strcmp(buffer, "99999") == 0);
+    }
+    assert(dup_hash[0] == dup_hash[1]); /* Same pairs in file order */
+    ini_doc_mem_t serial_mem, parallel_mem;
+    assert(ini_doc_memory(p_parsed[0], &serial_mem) == 0 && ini_doc_memory(p_parsed[1], &parallel_mem) == 0);
+    assert(serial_mem.keys == parallel_mem.keys && serial_mem.sections == parallel_mem.sections);
+    assert(serial_mem.names == parallel_mem.names && serial_mem.names == 100000 + 2 + 4 + 100); /* Sections, "", dup, top, key, name, first, k0..k99 */
+    for (int i = 0; i < 100000; i += 777) {
+        char section[16], values[2][MAX_LINE_LENGTH];
+        snprintf(section, sizeof(section), "s%d", i);
+        assert(ini_get(p_parsed[0], section, "name", values[0], MAX_LINE_LENGTH) > 0);
+        assert(ini_get(p_parsed[1], section, "name", values[1], MAX_LINE_LENGTH) > 0);
+        assert(strcmp(values[0], values[1]) == 0);
+    }
+    ini_close(p_parsed[0]);
+    ini_close(p_parsed[1]);
+    ini_parse_threads(0);
+    remove(inifile2);
+    printf("✅ Test passed: parallel parse\n");
+    char arena_text[4096] = "";
+    for (int i = 0; i < 50; ++i) {
+        size_t used = strlen(arena_text);
+        snprintf(arena_text + used, sizeof(arena_text) - used, "[Node_%d]\nId = %d\n%s = \"v\"\n", i, i, i % 2 ? "Addr" : "ADDR");
+    }
+    assert(ini_open_mem(arena_text, strlen(arena_text), &doc) == 0);
+    ini_doc_mem_t mem;
+    assert(ini_doc_memory(doc, &mem) == 0);
+    assert(mem.keys == 100 && mem.sections == 51 && mem.names == 50 + 1 + 3); /* Sections, "", Id, Addr, ADDR */
+    assert(mem.string_bytes > 0 && mem.string_bytes <= mem.arena_bytes && mem.arena_bytes < mem.total_bytes);
+    assert(mem.bytes_per_key > 0 && mem.total_bytes > mem.arena_bytes + mem.table_bytes);
+    result = ini_get(doc, "NODE_49", "addr", buffer, MAX_LINE_LENGTH);
+    assert(result == 1 && strcmp(buffer, "v") == 0);
+    struct section_list spelled = { 0, "" };
+    assert(ini_doc_section(doc, "node_2", collect_keys, &spelled) == 2);
+    assert(strcmp(spelled.keys, "Id,ADDR,") == 0); /* Names as written */
+    ini_close(doc);
+    printf("✅ Test passed: arena storage\n");
+    const char escaped[] = "[esc]\nhex = \"\\x41\\x7e\\'\\xZ\\q\" ; c\nrun = \"plain # text\\t\\\"end\\\" and more\"\n";
+    result = ini_read_key_mem(escaped, sizeof(escaped) - 1, "esc", "hex", buffer, MAX_LINE_LENGTH);
+    assert(result == 8 && strcmp(buffer, "A~'\\xZ\\q") == 0); /* Malformed and unknown escapes kept */
+    result = ini_read_key_mem(escaped, sizeof(escaped) - 1, "esc", "run", buffer, MAX_LINE_LENGTH);
+    assert(result == 19 && strcmp(buffer, "plain # text\t\"end\" ") == 0); /* Truncated */
+    const char unescaped[] = "[esc]\nview = \"a;b\" ; c:\\dir \"x\"\n"; /* Escape and quotes only in the comment */
+    result = ini_read_key_mem(unescaped, sizeof(unescaped) - 1, "esc", "view", buffer, MAX_LINE_LENGTH);
+    assert(result == 3 && strcmp(buffer, "a;b") == 0);
+    const char* odd_values[] = { "a # b", " padded\t", "two\nlines\r", "back\\slash \"q\"", "\x01\x7f;", "\"pre\" ; c" };
+    ini_txn_t* p_esc = NULL;
+    assert(ini_begin(inifile2, &p_esc) == 0);
+    char odd_key[8];
+    for (int i = 0; i < 6; ++i) {
+        snprintf(odd_key, sizeof(odd_key), "k%d", i);
+        assert(ini_set(p_esc, "odd", odd_key, odd_values[i], NULL) == 0);
+    }
+    assert(ini_commit(p_esc) == 0);
+    for (int i = 0; i < 6; ++i) {
+        snprintf(odd_key, sizeof(odd_key), "k%d", i);
+        result = ini_read_key(inifile2, "odd", odd_key, buffer, MAX_LINE_LENGTH);
+        assert(result >= 0 && strcmp(buffer, i < 5 ? odd_values[i] : "pre") == 0); /* Pre-quoted kept */
+    }
+    remove(inifile2);
+    printf("✅ Test passed: escape codec\n");
 
     return 0;
 }
\ No newline at end of file
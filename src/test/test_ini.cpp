@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <string>
+#include "../ini.hpp"
+
+/* Compile time hashing must match the library */
+static_assert(settings::key_hash("Net", "TimeOut") == settings::key_hash("net", "timeout"));
+static_assert(settings::key_hash("a", "bc") != settings::key_hash("ab", "c"));
+
+int main(void) {
+    const char inifile[] = "./test/test_cpp.ini";
+    FILE* file = std::fopen(inifile, "wb");
+    assert(file != nullptr);
+    std::fputs("[net]\nhost = example.org ; comment\ntimeout = 250ms\nretry = yes\n"
+               "url = http://localhost:8080/a/long/path/name/that/does/not/fit/into/small/buffers\n", file);
+    std::fclose(file);
+
+    constexpr settings::Key host{"Net", "Host"};
+    assert(host.hash == ini_key_hash("net", "host"));
+
+    settings::Document doc(inifile);
+    assert(doc && doc.error() == 0);
+    assert(doc.get(host) == std::string_view("example.org"));
+    assert(doc.get("NET", "url")->size() == 75); /* No truncation */
+    assert(!doc.get("net", "missing"));
+    assert(doc.get_or(settings::Key{"net", "missing"}, "none") == "none");
+    assert(doc.get_duration("net", "timeout") == 250000000);
+    assert(doc.get_bool("net", "retry") && doc.get_int("net", "host", 7) == 7);
+
+    std::string keys;
+    int count = doc.for_each("net", [&](std::string_view key, std::string_view) { keys.append(key).append(","); });
+    assert(count == 4 && keys == "host,timeout,retry,url,");
+    count = doc.for_each("net", [](std::string_view, std::string_view) { return false; });
+    assert(count == 1);
+
+    settings::Document moved = std::move(doc);
+    assert(!doc && moved.get(host));
+    settings::Document missing("./test/missing.ini");
+    assert(!missing && missing.error() < 0 && !missing.get(host));
+    std::string text = "[net]\nhost = \"in memory\"\n";
+    settings::Document from_text = settings::Document::from_buffer(text);
+    text.clear(); /* Document owns its copy */
+    assert(from_text && from_text.get(host) == std::string_view("in memory"));
+    std::remove(inifile);
+    std::printf("✅ Test passed: C++ wrapper\n");
+    return 0;
+}
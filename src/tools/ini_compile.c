@@ -0,0 +1,24 @@
+/*****************************************************************************
+ * @file      ini_compile.c
+ * @brief     Compile INI files into binary images loaded by ini_open()
+ * @details   Usage: ini_compile file.ini [image]
+ *            The image defaults to file.ini.bin next to the source, the
+ *            only name ini_open() loads. Another name is for staging, rename
+ *            it to file.ini.bin to use it.
+ ****************************************************************************/
+#include <stdio.h>
+#include "../ini.h"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s file.ini [image]\n", argv[0]);
+        return 2;
+    }
+
+    int result = ini_compile(argv[1], argc == 3 ? argv[2] : NULL);
+    if (result < 0) {
+        fprintf(stderr, "%s: %s\n", argv[1], ini_error_string(result));
+        return 1;
+    }
+    return 0;
+}